@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "loadobj.h"
+#include "meshcache.h"
+
+// 在工作线程中加载网格（解析、法线、优化、LOD 或映射缓存），主线程轮询结果
+// - 加载期间可随时查询已知的包围盒，用于绘制占位
+// - finished() 之后 buffers() 指向本对象持有的数据，release() 前保持有效
+class AsyncMeshLoader {
+public:
+    AsyncMeshLoader();
+    ~AsyncMeshLoader();
+
+    // 开始加载；flat = true 时加载逐角点展开的顶点数组（无索引）
+    void start(const std::string& filename, const ObjLoadOptions& options, bool useCache, bool flat);
+
+    // 工作线程已结束（成功或失败）
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+    bool succeeded() const { return finished() && ok_; }
+
+    // 模型包围盒：解析出位置后即可用，早于 finished()
+    bool bounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+
+    const MeshBuffers& buffers() const { return buffers_; }
+    bool cacheHit() const { return cacheHit_; }
+    double loadMs() const { return loadMs_; }
+
+    // 释放 CPU 侧数据与缓存映射（上传完成后调用）
+    void release();
+
+private:
+    AsyncMeshLoader(const AsyncMeshLoader&);
+    AsyncMeshLoader& operator=(const AsyncMeshLoader&);
+
+    void run(std::string filename, ObjLoadOptions options, bool useCache, bool flat);
+    void setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    std::thread thread_;
+    std::atomic<bool> finished_;
+    bool ok_;
+
+    mutable std::mutex boundsMutex_;
+    bool hasBounds_;
+    glm::vec3 boundsMin_;
+    glm::vec3 boundsMax_;
+
+    Mesh mesh_;
+    MeshCache cache_;
+    PackedMesh packed_;
+    std::vector<float> flatVertices_;
+    MeshBuffers buffers_;
+    bool cacheHit_;
+    double loadMs_;
+};
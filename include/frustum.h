@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// 批量剔除用的包围体数组（SoA），SIMD 一次测试 4 个
+struct SphereArrays {
+    std::vector<float> x, y, z, radius;
+
+    void resize(size_t count);
+    size_t size() const { return x.size(); }
+};
+
+struct BoxArrays {
+    std::vector<float> x, y, z;    // 中心
+    std::vector<float> ex, ey, ez; // 各轴半长
+
+    void resize(size_t count);
+    size_t size() const { return x.size(); }
+};
+
+// 模型空间 AABB（center ± extent）经各 models[i] 变换后的世界空间 AABB（Arvo：半长乘以 |M| 的 3×3 部分）
+void transformBox(const glm::vec3& center, const glm::vec3& extent, const glm::mat4* models, size_t count,
+                  BoxArrays& out);
+
+// 视锥体：6 个法线朝内的归一化平面 (n, d)，点 p 在内侧当 dot(n, p) + d >= 0
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // 从裁剪矩阵提取平面（Gribb / Hartmann）；传入 MVP 时平面位于模型空间
+    static Frustum fromMatrix(const glm::mat4& m);
+
+    // 球是否与视锥体相交（保守判定）
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+
+    // 批量测试（SSE2 每次 4 个，其余逐个）：visible[i] 置 1 / 0，返回可见个数
+    unsigned cullSpheres(const SphereArrays& spheres, uint8_t* visible) const;
+    unsigned cullBoxes(const BoxArrays& boxes, uint8_t* visible) const;
+};
+
+// 逐帧累加的视锥剔除统计（物体与网格簇），按秒输出后 reset
+struct FrustumCullTotals {
+    unsigned frames;
+    unsigned objectsVisible, objectsCulled;
+    unsigned chunksVisible, chunksCulled;
+    double ms; // 剔除耗时
+
+    // 输出一行每帧平均值（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+    void reset() { *this = FrustumCullTotals(); }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Extensions and entry points beyond the glad-generated GL 4.1 loader,
+// resolved at runtime after the context is current.
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// GL_ARB_buffer_storage (core in 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// Compute shaders, shader storage buffers, image load/store and multi-draw indirect (core in 4.2 / 4.3)
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+// Conservative occlusion queries (core in 4.3 / GL_ARB_ES3_compatibility)
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered,
+                                                   GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect,
+                                                            GLsizei drawCount, GLsizei stride);
+
+struct GLExtensions {
+    bool parallelShaderCompile;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads;
+    // Separable programs and program pipelines (GL 4.1 / GL_ARB_separate_shader_objects).
+    // The extension uses the unsuffixed core names, so on a pre-4.1 context the glad
+    // pointers (glUseProgramStages, glProgramUniform*, ...) are filled in from it.
+    bool separateShaderObjects;
+    // Immutable buffer storage, which allows persistent coherent mappings
+    bool bufferStorage;
+    PFNGLBUFFERSTORAGEPROC bufferStorageEntry;
+    // GPU-driven rendering (GL 4.3): compute culling that writes indirect draw commands
+    bool computeCulling;
+    PFNGLDISPATCHCOMPUTEPROC dispatchCompute;
+    PFNGLMEMORYBARRIERPROC memoryBarrier;
+    PFNGLBINDIMAGETEXTUREPROC bindImageTexture;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect;
+    // Occlusion query target: GL_ANY_SAMPLES_PASSED_CONSERVATIVE where supported, else the
+    // exact GL_ANY_SAMPLES_PASSED (core in 3.3)
+    GLenum occlusionQueryTarget;
+};
+
+// Query extension support; call once after gladLoadGLLoader
+void loadGLExtensions();
+const GLExtensions& glExtensions();
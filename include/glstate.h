@@ -0,0 +1,109 @@
+#pragma once
+
+#include <iosfwd>
+
+#include <glad/glad.h>
+
+// Shadow copy of the GL state the renderer changes. Every setter compares against
+// the last value it set and only calls GL when it differs, so code can state what
+// it needs before each draw without tracking what is already bound. All program,
+// vertex array, buffer, texture and fixed-function state changes go through here;
+// state changed behind its back must be followed by invalidate().
+
+// State change counters, accumulated until reset
+struct GLStateStats {
+    unsigned issued;   // GL calls made
+    unsigned filtered; // value already current
+
+    // One "GL state:" line with per-frame averages over `frames` frames
+    void report(std::ostream& out, unsigned frames) const;
+};
+
+class GLState {
+public:
+    GLState();
+
+    // Forget all cached values; the next call of every setter reaches GL
+    void invalidate();
+
+    void useProgram(GLuint program);
+    void bindProgramPipeline(GLuint pipeline);
+    void bindVertexArray(GLuint vao);
+    // GL_ELEMENT_ARRAY_BUFFER is tracked per vertex array
+    void bindBuffer(GLenum target, GLuint buffer);
+    // Indexed uniform buffer binding; also replaces the generic GL_UNIFORM_BUFFER binding
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    // Indexed binding of the whole buffer (cached as a range of size -1)
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void activeTexture(GLenum unit);
+    // Binds to the active texture unit
+    void bindTexture(GLenum target, GLuint texture);
+
+    void setEnabled(GLenum capability, bool enabled);
+    void depthMask(bool write);
+    void colorMask(bool write);
+    void depthFunc(GLenum func);
+    void blendFunc(GLenum src, GLenum dst);
+    void cullFace(GLenum face);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Delete objects and drop them from every binding they occupy, as GL does
+    void deleteProgram(GLuint program);
+    void deleteProgramPipeline(GLuint pipeline);
+    void deleteVertexArray(GLuint vao);
+    void deleteBuffer(GLuint buffer);
+    void deleteTexture(GLuint texture);
+
+    GLStateStats stats() const { return stats_; }
+    void resetStats() { stats_.issued = stats_.filtered = 0; }
+
+private:
+    GLState(const GLState&);
+    GLState& operator=(const GLState&);
+
+    static const int kBufferTargets = 6;
+    static const int kUniformBindings = 16;
+    static const int kTextureUnits = 16;
+    static const int kTextureTargets = 4;
+    static const int kCapabilities = 6;
+
+    struct Range {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    // Returns true (and counts the call) when `cached` differs from `value`, updating it
+    template <typename T>
+    bool change(T& cached, T value) {
+        if (cached == value) {
+            ++stats_.filtered;
+            return false;
+        }
+        cached = value;
+        ++stats_.issued;
+        return true;
+    }
+    bool changeRect(GLint (&cached)[4], GLint x, GLint y, GLsizei width, GLsizei height);
+
+    GLStateStats stats_;
+    // Cached values are kUnknown (all bits set) until first set or after invalidate()
+    GLuint program_;
+    GLuint pipeline_;
+    GLuint vao_;
+    GLuint buffers_[kBufferTargets];
+    Range uniformRanges_[kUniformBindings];
+    GLenum activeUnit_;
+    GLuint textures_[kTextureUnits][kTextureTargets];
+    GLuint capabilities_[kCapabilities];
+    GLuint depthMask_, colorMask_;
+    GLenum depthFunc_;
+    GLenum blend_[2];
+    GLenum cullFace_;
+    GLint scissor_[4];
+    GLint viewport_[4];
+};
+
+// The state of the one GL context the renderer uses
+GLState& glState();
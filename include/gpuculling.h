@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "instancing.h"
+#include "mesh.h"
+#include "renderqueue.h"
+#include "shader.h"
+#include "uniformblocks.h"
+
+// glMultiDrawElementsIndirect 的命令格式（与 GL 规定一致，std430 下布局相同）
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand layout");
+
+// GPU 剔除所绘制的网格：mesh 的 VAO 已设置顶点属性与索引缓冲，输出实例属性由 GpuCuller 挂接
+struct GpuCullMesh {
+    GLuint vao;
+    GLenum indexType;
+    unsigned indexSize;
+    unsigned indexCount;  // 完整网格的索引数
+    const MeshLod* lods;  // 可为 NULL；lodThreshold > 0 且多于一级时逐实例选择 LOD
+    unsigned lodCount;
+    float lodThreshold;   // 允许的屏幕空间误差（像素）
+    glm::vec3 boundsCenter;  // 模型空间 AABB
+    glm::vec3 boundsExtent;
+    float boundsRadius;
+};
+
+// GPU 驱动的实例剔除（GL 4.3 计算着色器 + glMultiDrawElementsIndirect）
+// - 输入为常驻 GPU 的 InstanceBuffer，只含各实例的排布变换与材质，排布变化时才由 CPU 重新上传；
+//   各实例共用的逐帧模型矩阵经 CullBlock 传入，由着色器合成完整变换，CPU 每帧的开销与实例数无关
+// - 以 SSBO 读取输入
+// - gpucull.comp 每个线程测试一个实例的世界空间 AABB，可见者以原子计数追加到输出 InstanceBuffer 中
+//   对应 (阶段, LOD) 的区域，同时累加该区域间接绘制命令的 instanceCount
+// - 两阶段遮挡剔除（深度金字塔取自本帧）：
+//   阶段 0 绘制视锥内且上一帧可见的实例；之后由其深度建立层级最远深度金字塔（hiz.comp），
+//   阶段 1 以金字塔测试全部视锥内实例、更新可见标记，并补画上一帧不可见但本帧可见者
+// - 每帧的 GL 调用数只与金字塔级数有关，与实例数无关；CPU 不回读剔除结果（统计除外）
+class GpuCuller {
+public:
+    static const int kPhases = 2;
+
+    GpuCuller();
+    ~GpuCuller();
+
+    // 编译计算着色器并分配可容纳 instanceCapacity 个输入实例的缓冲；失败时返回 false
+    bool create(const std::string& shaderDir, size_t instanceCapacity);
+    // 网格就绪后调用一次
+    void setMesh(const GpuCullMesh& mesh);
+    bool ready() const { return vao_ != 0; }
+
+    // 本帧参数：camera 为世界空间相机位置，pixelScale 为视口高 / (2 tan(fovy / 2))；
+    // input（容量与 create 的 instanceCapacity 相同）已写入 instanceCount 个实例的排布变换，
+    // 第 i 个实例的模型矩阵为 input.model[i] * objectModel。重置绘制命令并绑定各缓冲
+    void beginFrame(const glm::mat4& viewProj, const glm::mat4& objectModel, const glm::vec3& camera,
+                    float pixelScale, const InstanceBuffer& input, size_t instanceCount, int width, int height);
+    // 剔除并写出阶段 phase 的绘制命令；阶段 1 须在 buildDepthPyramid 之后
+    void cull(int phase);
+    // 复制默认帧缓冲的深度（阶段 0 已绘制）并逐级取 2×2 最远深度
+    void buildDepthPyramid();
+
+    // 阶段 phase 的绘制（VAO 为 vao()，须在 cull(phase) 之后执行，间接缓冲由 cull 绑定）
+    DrawCommand draw(int phase) const;
+    GLuint vao() const { return vao_; }
+    // 每个阶段向 queue 提交一个以 shader 绘制的间接绘制项，阶段 1 的 pass 为 RENDER_PASS_OPAQUE_LATE
+    void submit(RenderQueue& queue, Shader* shader) const;
+    // 执行 queue（cull(0) 之后）：阶段 0 的绘制，之后建立深度金字塔、剔除阶段 1，再执行阶段 1 的绘制
+    template <typename F>
+    void execute(RenderQueue& queue, const UniformBuffer& materials, F setObject) {
+        queue.execute(materials, setObject, RENDER_PASS_OPAQUE, RENDER_PASS_OPAQUE);
+        buildDepthPyramid();
+        cull(1);
+        queue.execute(materials, setObject, RENDER_PASS_OPAQUE_LATE, RENDER_PASS_OPAQUE_LATE);
+    }
+
+    // 每帧的 GL 调用数（含被 GLState / uniform 缓存过滤的调用）
+    unsigned callsPerFrame() const { return calls_; }
+    // 回读本帧各阶段绘制的实例数（等待 GPU 完成），仅用于统计输出
+    void readVisibleCounts(unsigned& early, unsigned& late) const;
+    // 输出一行本帧绘制的实例数（经 readVisibleCounts）与剔除的 GL 调用数
+    void report(std::ostream& out, size_t instanceCount) const;
+
+private:
+    GpuCuller(const GpuCuller&);
+    GpuCuller& operator=(const GpuCuller&);
+
+    void resizePyramid(int width, int height);
+
+    Shader cullShader_;
+    Shader hizShader_;
+    Uniform<int> phaseUniform_;
+    Uniform<int> levelUniform_;
+    UniformBuffer params_;
+    CullBlock block_;
+    size_t capacity_;
+    GpuCullMesh mesh_;
+    unsigned commandsPerPhase_;
+    DrawElementsIndirectCommand templates_[kPhases * kMaxLods];
+    InstanceBuffer output_;
+    GLuint vao_;
+    GLuint commands_;   // 间接绘制命令
+    GLuint visibility_; // 每个实例上一帧是否可见
+    GLuint depth_;      // 默认帧缓冲深度的副本
+    GLuint pyramid_;    // R32F，逐级 2×2 最远深度
+    int width_, height_, levels_;
+    unsigned calls_;
+};
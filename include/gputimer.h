@@ -0,0 +1,37 @@
+#pragma once
+
+#include <iosfwd>
+
+#include <glad/glad.h>
+
+// GPU 计时（GL_TIME_ELAPSED 查询）：结果延迟若干帧读取，不等待 GPU。
+// 同一时刻只能有一个 GL_TIME_ELAPSED 查询处于活动状态，计时区间不可嵌套。
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+
+    // 收取已完成的查询并累计；每帧调用
+    void collect();
+    // 自上次 reset 以来已收取区间的平均耗时（毫秒）
+    double averageMs() const { return samples_ ? totalMs_ / samples_ : 0.0; }
+    unsigned samples() const { return samples_; }
+    void reset() { totalMs_ = 0.0; samples_ = 0; }
+    // 输出一行 "GPU: <label> 平均耗时"（没有样本时不输出）
+    void report(std::ostream& out, const char* label) const;
+
+private:
+    GpuTimer(const GpuTimer&);
+    GpuTimer& operator=(const GpuTimer&);
+
+    static const int kQueries = 4;
+    GLuint queries_[kQueries];
+    bool pending_[kQueries];
+    int next_;
+    bool active_;
+    double totalMs_;
+    unsigned samples_;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64 位非加密哈希（XXH64 算法），用于缓存键与内容校验
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t hash64(const std::string& s, uint64_t seed = 0) {
+    return hash64(s.data(), s.size(), seed);
+}
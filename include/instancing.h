@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class DynamicRingBuffer;
+
+// 逐实例顶点属性位置（与 src/shader/*-vertex.vs 的 INSTANCED 分支一致），mat4 / mat3 各占连续 4 / 3 个位置
+const GLuint kInstanceModelLocation = 2;
+const GLuint kInstanceNormalLocation = 6;
+const GLuint kInstanceMaterialLocation = 9;
+
+// 逐实例数据（SoA）：每个字段一段连续数组，每帧整体更新后逐字段上传
+struct InstanceArrays {
+    std::vector<glm::mat4> model;
+    std::vector<glm::mat3> normal;  // 法线矩阵
+    std::vector<uint32_t> material; // 材质表下标（MaterialTableBlock，见 uniformblocks.h）
+
+    void resize(size_t count);
+    size_t size() const { return model.size(); }
+};
+
+// 以 spacing 为间距排布 gridSize × gridSize 个实例（以原点为中心）：列沿 X 轴，行沿 rowAxis（单位向量，
+// 默认 Y 轴即 XY 平面；取视线方向时各列前后排开、互相遮挡）。
+// 各实例在 model 变换之后平移到格点；材质下标沿对角线在前 materialCount 项中循环
+void layoutInstanceGrid(InstanceArrays& instances, int gridSize, float spacing, const glm::mat4& model,
+                        unsigned materialCount, const glm::vec3& rowAxis = glm::vec3(0.0f, 1.0f, 0.0f));
+
+// 网格就绪后逐帧累加的 CPU 耗时，按秒输出后 reset
+struct InstanceTotals {
+    unsigned frames;
+    double frameMs;  // CPU 帧耗时
+    double updateMs; // 实例数据计算与上传
+
+    // 输出一行每帧平均值（没有统计的帧时不输出）；triangles 为全部实例的三角形数
+    void report(std::ostream& out, size_t instances, long long triangles) const;
+    void reset() { *this = InstanceTotals(); }
+};
+
+// 实例属性缓冲：一段存储按字段分段 [model | normal | material]，属性分别指向各段，divisor 为 1
+class InstanceBuffer {
+public:
+    InstanceBuffer() : buffer_(0), capacity_(0), source_(0), base_(0) {}
+    ~InstanceBuffer();
+
+    // 分配可容纳 capacity 个实例的存储
+    void create(size_t capacity);
+    // 在 vao 上设置实例属性；之后数据所在位置变化时 update 会重新设置（结束时 vao 保持绑定）
+    void attach(GLuint vao);
+    // 上传（至多 capacity 个）实例
+    // - ring 有效且本帧区域有空间时写入持久映射的环形缓冲，属性改指向该次分配
+    // - 否则先以 glBufferData(NULL) 换新自有存储再上传，不等待 GPU 读完上一帧的数据
+    void update(const InstanceArrays& instances, DynamicRingBuffer* ring = NULL);
+
+    // 一帧实例数据的字节数
+    size_t bytes() const { return materialOffset() + capacity_ * sizeof(uint32_t); }
+    size_t capacity() const { return capacity_; }
+    // 各段相对数据起点的字节偏移
+    size_t normalOffset() const { return capacity_ * sizeof(glm::mat4); }
+    size_t materialOffset() const { return normalOffset() + capacity_ * sizeof(glm::mat3); }
+    // 自有存储，以及属性当前所指的缓冲与起始偏移（上一次 update 写入的位置）
+    GLuint storage() const { return buffer_; }
+    GLuint source() const { return source_; }
+    size_t base() const { return base_; }
+
+private:
+    InstanceBuffer(const InstanceBuffer&);
+    InstanceBuffer& operator=(const InstanceBuffer&);
+
+    // 让已挂接的 VAO 指向 buffer 中 base 处的数据
+    void setSource(GLuint buffer, size_t base);
+    void setPointers() const;
+
+    GLuint buffer_;
+    size_t capacity_;
+    std::vector<GLuint> vaos_;
+    GLuint source_; // 当前属性所指的缓冲与起始偏移
+    size_t base_;
+};
@@ -1,9 +1,35 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 #include <string>
 
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "normals.h"
+#include "vertexformat.h"
+
+// 加载选项
+struct ObjLoadOptions {
+    unsigned threads = 0; // 解析与法线计算线程数：0 = 全部核心，1 = 串行
+    NormalWeighting normalWeighting = NORMALS_ANGLE; // 未提供 vn 时平滑法线的加权方式
+    bool optimize = true; // 索引网格是否做顶点缓存 / 过度绘制 / 顶点拉取优化
+    bool lods = true; // 索引网格是否生成 LOD 链（kLodRatios）
+    VertexFormat vertexFormat = VERTEX_FLOAT32; // 上传 GPU 的顶点格式（loadOBJCached 使用）
+    // 解析出顶点位置后立即回调模型包围盒（可在加载线程中调用；不影响输出与缓存）
+    std::function<void(const glm::vec3& boundsMin, const glm::vec3& boundsMax)> onBounds;
+};
+
 // 加载 OBJ 文件，返回交错数组: pos(3) + normal(3)
 // - filename: OBJ 路径
 // - vertexCount: 输出顶点数量（用于 glDrawArrays 的 count）
 std::vector<float> loadOBJ(const std::string& filename, int& vertexCount);
+std::vector<float> loadOBJ(const std::string& filename, int& vertexCount, const ObjLoadOptions& options);
+
+// 加载 OBJ 为去重后的索引网格（用于 glDrawElements）
+// - 顶点布局与 loadOBJ 相同；索引宽度见 Mesh::indexSize()
+// - options.optimize 时去重后按 optimizeMesh 重排三角形与顶点
+// - options.lods 时在 LOD 0 之后追加简化的 LOD 链，见 Mesh::lods
+// - 打不开文件时返回 false
+bool loadOBJMesh(const std::string& filename, Mesh& mesh, const ObjLoadOptions& options = ObjLoadOptions());
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "meshlet.h"
+
+// 顶点属性分量类型（与 GL 枚举解耦，便于写入缓存文件）
+enum VertexAttribType : uint32_t {
+    ATTRIB_FLOAT32 = 0,
+    ATTRIB_UNORM16,            // 归一化 uint16 -> [0, 1]
+    ATTRIB_SNORM16,            // 归一化 int16 -> [-1, 1]
+    ATTRIB_SNORM_2_10_10_10,   // GL_INT_2_10_10_10_REV 归一化，4 分量共 32 位
+};
+
+// 单个顶点属性：layout(location) 与在顶点中的偏移
+struct VertexAttrib {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;   // VertexAttribType
+    uint32_t offset; // 字节
+};
+
+// 交错顶点布局描述
+struct VertexLayout {
+    enum { kMaxAttribs = 4 };
+    uint32_t stride;
+    uint32_t attribCount;
+    VertexAttrib attribs[kMaxAttribs];
+
+    // pos(3 float) + normal(3 float)，stride 24
+    static VertexLayout positionNormal();
+};
+
+// LOD 级别：索引缓冲中的一段范围，各级共享同一顶点缓冲（写入缓存文件）
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;    // 相对完整网格的几何误差（模型空间距离），随级别单调不减
+    float reserved;
+};
+const unsigned kMaxLods = 8;
+
+// 索引三角网格
+// - vertices: 交错数组 pos(3) + normal(3)
+// - indices: 每 3 个为一个三角形；有 LOD 时依次存放各级
+// - meshlets: 覆盖 LOD 0 的连续簇，可为空
+// - lods: lods[0] 为完整网格，为空时全部 indices 为唯一一级
+struct Mesh {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshLod> lods;
+
+    int vertexCount() const { return static_cast<int>(vertices.size() / 6); }
+    int indexCount() const { return static_cast<int>(indices.size()); }
+
+    // 上传 GPU 时的索引字节宽度：顶点数不超过 65535 时用 16 位
+    unsigned indexSize() const { return vertexCount() <= 0xFFFF ? 2u : 4u; }
+
+    // 按 indexSize() 打包的索引数据
+    std::vector<unsigned char> packedIndices() const;
+
+    // 轴对齐包围盒，空网格时为 0
+    void computeBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+};
+
+// 可直接上传 GPU 的网格数据视图，数据归 Mesh 或映射的缓存文件所有
+struct MeshBuffers {
+    VertexLayout layout;
+    const void* vertexData;
+    size_t vertexBytes;
+    unsigned vertexCount;
+    const void* indexData;
+    size_t indexBytes;
+    unsigned indexCount;
+    unsigned indexSize; // 2 或 4
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    // 位置反量化：pos = positionOffset + positionScale * attrib（浮点布局为 0 / 1）
+    glm::vec3 positionScale;
+    glm::vec3 positionOffset;
+    const Meshlet* meshlets;
+    unsigned meshletCount;
+    const MeshLod* lods;
+    unsigned lodCount;
+};
+
+// 以 mesh 与其打包索引构造视图；两者需在视图使用期间保持有效
+MeshBuffers makeMeshBuffers(const Mesh& mesh, const std::vector<unsigned char>& packedIndices);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "loadobj.h"
+#include "mappedfile.h"
+#include "mesh.h"
+
+// 二进制网格缓存（<源文件>.pmesh）
+//
+// 文件布局（小端）：
+//   MeshCacheHeader | 顶点数据 | 索引数据 | 网格簇（Meshlet 数组）
+// 各段均按 kMeshCacheAlign 对齐，映射后可直接交给 glBufferData。
+// 源文件大小或内容哈希不一致、或加载选项影响的输出不同时缓存失效；
+// 修改时间一致时跳过内容哈希。
+// 头部的偏移、尺寸与顶点布局逐项校验，任一不合法都按未命中处理并重建。
+const uint32_t kMeshCacheVersion = 4;
+const uint64_t kMeshCacheAlign = 4096;
+
+struct MeshCacheHeader {
+    char magic[8];          // "PSMESH\0\0"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sourceSize;
+    int64_t sourceMtime;    // 纳秒
+    uint64_t sourceHash;    // hash64(源文件内容)
+    uint64_t optionsHash;   // 影响输出的加载选项
+    VertexLayout layout;
+    float boundsMin[3];
+    float boundsMax[3];
+    float positionScale[3];  // 量化位置的反量化参数，见 MeshBuffers
+    float positionOffset[3];
+    float positionError;     // 实测量化误差，浮点格式为 0
+    float normalError;       // 度
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t vertexBytes;
+    uint64_t indexOffset;
+    uint64_t indexBytes;
+    uint64_t meshletOffset;
+    uint64_t meshletBytes;
+    uint32_t meshletCount;
+    uint32_t lodCount;
+    MeshLod lods[kMaxLods];  // 索引数据中的各级范围，lods[0] 为完整网格
+};
+
+// 源文件对应的缓存路径
+std::string meshCachePath(const std::string& sourcePath);
+
+// 已映射的缓存文件
+class MeshCache {
+public:
+    // 映射并校验缓存，失败（不存在、损坏或过期）返回 false
+    bool open(const std::string& cachePath, const std::string& sourcePath, const ObjLoadOptions& options);
+    void close() { file_.close(); }
+
+    // 指向映射内存的视图，映射关闭后失效
+    const MeshBuffers& buffers() const { return buffers_; }
+    const QuantizationError& quantizationError() const { return error_; }
+
+private:
+    MappedFile file_;
+    MeshBuffers buffers_;
+    QuantizationError error_;
+};
+
+// 写入缓存（先写临时文件再改名），失败返回 false
+bool writeMeshCache(const std::string& cachePath, const std::string& sourcePath,
+                    const ObjLoadOptions& options, const MeshBuffers& buffers,
+                    const QuantizationError& error);
+
+// 加载索引网格，优先使用有效缓存，未命中时解析 OBJ 并写回缓存
+// - 命中时 buffers 指向 cache 的映射内存，否则指向 mesh / packed
+// - 顶点按 options.vertexFormat 打包，量化格式会输出实测误差
+// - useCache = false 时直接解析且不写缓存
+// - 失败（文件缺失或解析出错）时返回 false，buffers 为空视图（尺寸为 0、指针为 NULL）
+bool loadOBJCached(const std::string& filename, const ObjLoadOptions& options, bool useCache,
+                   MeshCache& cache, Mesh& mesh, PackedMesh& packed,
+                   MeshBuffers& buffers, bool& cacheHit);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+#include "mesh.h"
+#include "meshlet.h"
+#include "renderqueue.h"
+
+// 索引网格的逐物体绘制命令（单个物体与 --no-instancing；实例化时所有实例共用完整网格）
+// - 给出 LOD 阈值且多于一级时，选择屏幕空间误差不超过阈值的最粗一级：
+//   误差像素数 = error * 视口高 / (2 tan(fovy / 2) * 距离)
+// - 简化级别直接绘制其索引范围（共享顶点缓冲）；完整网格有簇时剔除簇，相邻可见簇合并为一次多段绘制
+class MeshDrawSelector {
+public:
+    MeshDrawSelector();
+
+    // 网格就绪后调用（在释放加载器前，簇与 LOD 数据复制一份）；cullMeshlets 为 false 时整网格绘制。
+    // boundsCenter / boundsRadius 为模型空间包围球，用于误差估计
+    void setMesh(const MeshBuffers& mb, bool cullMeshlets, float lodThreshold, const glm::vec3& boundsCenter,
+                 float boundsRadius);
+    const std::vector<MeshLod>& lods() const { return lods_; }
+    // 完整网格（LOD 0）的索引数
+    GLsizei fullIndexCount() const;
+
+    // 开始一帧：objectCount 个物体，pixelScale 为视口高 / (2 tan(fovy / 2))
+    void beginFrame(size_t objectCount, float pixelScale);
+    // 物体 object 的绘制命令：mvp 为其 proj * view * model，cameraPos 为相机在其模型空间的位置。
+    // 簇全部被剔除时返回空命令；命令引用的范围数组保留到下一次 beginFrame。
+    // 只有一个物体时 LOD 级别变化输出一行
+    DrawCommand select(size_t object, const glm::mat4& mvp, const glm::vec3& cameraPos);
+    // 本帧的簇剔除结果与耗时计入统计
+    void endFrame(FrustumCullTotals& cullStats, MeshletCullTotals& meshletStats) const;
+
+private:
+    MeshDrawSelector(const MeshDrawSelector&);
+    MeshDrawSelector& operator=(const MeshDrawSelector&);
+
+    int selectLod(const glm::vec3& cameraPos, float& errorPixels) const;
+
+    GLenum indexType_;
+    unsigned indexSize_;
+    unsigned indexCount_;
+    std::vector<Meshlet> meshlets_;
+    SphereArrays meshletBounds_;
+    std::vector<MeshLod> lods_;
+    float lodThreshold_;
+    glm::vec3 boundsCenter_;
+    float boundsRadius_;
+    // 本帧
+    size_t objectCount_;
+    float pixelScale_;
+    std::vector<MeshletDrawList> draws_; // 逐物体的可见簇范围
+    MeshletCullStats frameCull_;
+    unsigned frameRanges_;
+    double frameMs_;
+    int currentLod_; // 单个物体最近输出的级别
+};
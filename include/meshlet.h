@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+
+struct Mesh;
+
+// 单簇上限（与常见 mesh shader 配置一致）
+const unsigned kMeshletMaxVertices = 64;
+const unsigned kMeshletMaxTriangles = 124;
+
+// 网格簇：索引缓冲中一段连续三角形及其包围信息（模型空间，写入缓存文件）
+// - 包围球 center / radius 用于视锥剔除
+// - 法线锥：视线方向 normalize(coneApex - 相机) 与 coneAxis 夹角余弦 >= coneCutoff 时
+//   簇内所有三角形均背向相机；coneCutoff >= 1 表示不可剔除
+struct Meshlet {
+    uint32_t indexOffset;   // 起始索引（以索引个数计）
+    uint32_t triangleCount;
+    uint32_t vertexCount;   // 簇内不同顶点数
+    float coneCutoff;
+    float center[3];
+    float radius;
+    float coneApex[3];
+    float coneAxis[3];
+};
+
+// 按当前三角形顺序贪心切分为不超过上限的连续簇并计算包围信息
+// - 建议在 optimizeMesh 之后调用，簇继承其顶点缓存局部性
+// - 网格不封闭（按位置焊接后存在边界边）时背面三角形可能可见，所有簇都不做法线锥剔除
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh);
+
+// 每帧剔除统计
+struct MeshletCullStats {
+    unsigned total;
+    unsigned frustumCulled;
+    unsigned backfaceCulled;
+};
+
+// 逐帧累加的剔除统计，按秒输出后 reset
+struct MeshletCullTotals {
+    unsigned frames;
+    unsigned total, frustumCulled, backfaceCulled;
+    unsigned draws;                 // 合并后的绘制范围数
+    float culledSum, culledMin, culledMax; // 每帧剔除比例（%）
+    unsigned meshlets;              // 最近一帧测试的簇数
+
+    // 累加一帧：stats 为该帧所有 cullMeshlets 调用之和，draws 为该帧的绘制范围数
+    void add(const MeshletCullStats& stats, unsigned draws);
+    // 输出一行每帧平均值（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+    void reset() { *this = MeshletCullTotals(); }
+};
+
+// 可见簇合并后的绘制范围，可直接用于 glMultiDrawElements
+struct MeshletDrawList {
+    std::vector<int> counts;          // 索引个数
+    std::vector<const void*> offsets; // 索引缓冲内字节偏移
+    std::vector<uint8_t> visible;     // 视锥测试结果（每簇一项，内部使用）
+};
+
+// 簇包围球的 SoA 副本，供批量视锥测试；上传网格时生成一次
+void meshletSpheres(const Meshlet* meshlets, unsigned count, SphereArrays& spheres);
+
+// 以模型空间视锥与相机位置剔除簇，相邻的可见簇合并为一次绘制
+// - spheres: meshletSpheres 的结果，视锥测试对全部簇批量进行
+// - mvp: proj * view * model；cameraPos: 相机在模型空间的位置
+void cullMeshlets(const Meshlet* meshlets, const SphereArrays& spheres, unsigned count, unsigned indexSize,
+                  const glm::mat4& mvp, const glm::vec3& cameraPos,
+                  MeshletDrawList& draws, MeshletCullStats& stats);
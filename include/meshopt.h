@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "mesh.h"
+
+// 优化目标的后变换顶点缓存大小（FIFO）
+const unsigned kVertexCacheSize = 16;
+
+// 顶点缓存模拟结果
+// - acmr: 平均每三角形缓存未命中数（理想值约 0.5，最差 3）
+// - atvr: 未命中数 / 顶点数（理想值 1）
+struct VertexCacheStats {
+    float acmr;
+    float atvr;
+};
+
+// 以 FIFO 缓存模拟索引序列的顶点变换次数
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                    unsigned cacheSize = kVertexCacheSize);
+
+// Tipsify（Sander et al. 2007）三角形重排，提高顶点缓存命中率
+// - clusters 非空时输出硬边界：每段起始三角形下标（首元素为 0），
+//   即缓存在此处被“清空”的位置，供 optimizeOverdraw 使用
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+                         unsigned cacheSize = kVertexCacheSize, std::vector<unsigned int>* clusters = nullptr);
+
+// 与视角无关的过度绘制优化：在 Tipsify 硬边界内按 ACMR 阈值细分簇，
+// 再按簇朝外程度（簇中心相对网格中心在簇法线上的投影）从大到小排序，
+// 使外侧表面先绘制、被遮挡部分更多地被 early-Z 剔除
+// - vertices: 交错顶点数组，位置位于每个顶点的前 3 个 float，stride 以 float 计
+// - threshold: 允许的 ACMR 放大倍数，1.05 表示最多损失 5%
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusters,
+                      const float* vertices, size_t stride, size_t vertexCount,
+                      float threshold = 1.05f, unsigned cacheSize = kVertexCacheSize);
+
+// 按索引首次出现顺序重排顶点，提高顶点拉取的内存局部性；未被引用的顶点被丢弃
+void optimizeVertexFetch(Mesh& mesh);
+
+// 依次执行顶点缓存、过度绘制与顶点拉取优化，并输出优化前后的 ACMR / ATVR
+void optimizeMesh(Mesh& mesh);
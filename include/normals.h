@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "objparser.h"
+
+// 平滑顶点法线的面法线加权方式
+enum NormalWeighting {
+    NORMALS_ANGLE = 0,  // 角度加权（默认）
+    NORMALS_AREA,       // 面积加权（未归一化叉积直接累加）
+    NORMALS_ANGLE_AREA, // 角度 × 面积
+};
+
+// 解析 "angle" / "area" / "angle-area"，无法识别时返回 false
+bool parseNormalWeighting(const std::string& name, NormalWeighting& out);
+const char* normalWeightingName(NormalWeighting mode);
+
+// 由三角形角点计算按位置索引的平滑顶点法线
+// - 三角形按 SoA 批次用 AVX / SSE 计算（acos 使用多项式近似，float 运算下
+//   在 [-1, 1] 上的最大绝对误差为 4.4e-7 rad，逐一测试全部 float 输入所得）
+// - 每个角点的加权法线先写入独立槽位，再按 顶点→角点 表逐顶点汇总，
+//   无写冲突且结果与线程数无关
+// - 越界或退化三角形不参与累加；threads = 0 使用全部核心
+std::vector<glm::vec3> computeVertexNormals(const std::vector<glm::vec3>& positions,
+                                            const std::vector<ObjIndex>& corners,
+                                            NormalWeighting mode, unsigned threads = 0);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+#include "instancing.h"
+#include "mesh.h"
+#include "occlusion.h"
+
+// CPU 逐物体剔除（单个物体与 --grid；--gpu-culling 时由 GpuCuller 代替）
+// - 模型空间 AABB 经各物体的模型矩阵变换到世界空间，对 viewProj 的视锥平面批量测试
+// - 有遮挡体且多于一个物体时，由近到远取前 kMaxOccluders 个视锥内物体光栅化遮挡体，
+//   视锥内物体的 AABB 再与软件深度缓冲比较
+class ObjectCuller {
+public:
+    static const unsigned kMaxOccluderTriangles = 512;
+    static const size_t kMaxOccluders = 32;
+
+    ObjectCuller();
+
+    // 模型空间 AABB（中心 ± 半长），包围盒可用后调用
+    void setBounds(const glm::vec3& center, const glm::vec3& extent);
+    // 从网格的 LOD 中提取遮挡体（在释放加载器前调用）；没有合适的几何时返回 false，之后只做视锥剔除
+    bool setOccluder(const MeshBuffers& mb);
+    const OccluderMesh& occluder() const { return occluder_; }
+
+    // 剔除 count 个物体（models[i] 为第 i 个的模型矩阵），返回可见个数，逐物体结果见 visible()。
+    // stats 非 NULL 时累加物体数与视锥剔除耗时，同时计入遮挡剔除的统计（见 occlusionStats()）
+    unsigned cull(const glm::mat4& viewProj, const glm::vec3& camera, const glm::mat4* models, size_t count,
+                  FrustumCullTotals* stats);
+    const std::vector<uint8_t>& visible() const { return visible_; }
+    // 把上一次 cull 中可见的实例依次复制到 out
+    void compact(const InstanceArrays& instances, InstanceArrays& out) const;
+
+    const OcclusionTotals& occlusionStats() const { return occlusionStats_; }
+    void resetOcclusionStats() { occlusionStats_.reset(); }
+
+private:
+    ObjectCuller(const ObjectCuller&);
+    ObjectCuller& operator=(const ObjectCuller&);
+
+    // 以遮挡体剔除 boxes_ 中视锥内的 tested 个物体，返回被遮挡个数；record 时计入 occlusionStats_
+    unsigned cullOccluded(const glm::mat4& viewProj, const glm::vec3& camera, const glm::mat4* models,
+                          size_t count, unsigned tested, bool record);
+
+    glm::vec3 center_, extent_;
+    BoxArrays boxes_;
+    std::vector<uint8_t> visible_;
+    OccluderMesh occluder_;
+    OcclusionBuffer occlusion_;
+    std::vector<glm::mat4> occluderMVPs_;
+    std::vector<std::pair<float, uint32_t> > occluderOrder_;
+    OcclusionTotals occlusionStats_;
+};
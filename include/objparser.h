@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// OBJ 面角点索引（0 基），缺省为 -1
+struct ObjIndex { int v; int n; };
+
+// OBJ 解析结果
+// - corners: 每 3 个为一个三角形（四边形已拆分为 0-1-2, 0-2-3）
+// - 负数（相对）索引在解析时即解析为绝对索引
+struct ObjData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjIndex> corners;
+};
+
+// 预分配用的记录数估计
+struct ObjRecordCount {
+    size_t positions;
+    size_t normals;
+    size_t faces;
+};
+
+// 读取文件头部注释中的 "# vertex count = N" / "# face count = N" 提示，
+// 没有提示的字段为 0
+ObjRecordCount scanOBJHeaderHints(const char* begin, const char* end);
+
+// 快速扫描一遍统计 v / vn / f 记录数
+ObjRecordCount countOBJRecords(const char* begin, const char* end);
+
+// 分块解析时记录使用了负数（相对）索引的角点，便于拼接后按前缀和重定位
+struct ObjRelativeRefs {
+    std::vector<size_t> v; // corners 下标，其 .v 为相对索引
+    std::vector<size_t> n; // corners 下标，其 .n 为相对索引
+};
+
+// 解析 [begin, end) 中的 OBJ 文本，结果追加到 out
+// - rel 非空时记录相对索引角点（相对于 out 中已有记录数解析）
+void parseOBJRange(const char* begin, const char* end, ObjData& out, ObjRelativeRefs* rel = nullptr);
+
+// 将 [begin, end) 按换行对齐切块，在共享线程池上并行解析后拼接
+// - threads = 0 使用全部核心，1 退化为串行；输出与串行解析逐位一致
+void parseOBJParallel(const char* begin, const char* end, ObjData& out, unsigned threads = 0);
+
+// 映射并解析整个文件，打不开时返回 false；bytes 输出文件字节数
+// - threads 同 parseOBJParallel；小文件总是串行解析
+bool parseOBJFile(const std::string& filename, ObjData& out, size_t& bytes, unsigned threads = 1);
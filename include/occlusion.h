@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "frustum.h"
+#include "mesh.h"
+
+class ThreadPool;
+
+// 遮挡体：简化后的模型空间三角形（从网格的 LOD 中选取），在释放加载器前复制，常驻 CPU
+struct OccluderMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+
+    size_t triangleCount() const { return indices.size() / 3; }
+    bool empty() const { return indices.empty(); }
+};
+
+// 选取三角形数不超过 maxTriangles 的最精细 LOD，都超出时取最粗一级；无 LOD 时整个网格不超过上限才使用。
+// 位置按布局的属性 0 解码（浮点或反量化的 unorm16），只保留被引用的顶点。没有合适的几何时返回 false
+bool extractOccluder(const MeshBuffers& mb, unsigned maxTriangles, OccluderMesh& out);
+
+// 逐帧累加的软件遮挡剔除统计，按秒输出后 reset
+struct OcclusionTotals {
+    unsigned frames;
+    unsigned occluded, tested; // 被遮挡 / 参与测试的物体
+    unsigned occluders;
+    size_t triangles;          // 光栅化的遮挡体三角形
+    double rasterMs, testMs;
+
+    // 输出一行每帧平均值（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+    void reset() { *this = OcclusionTotals(); }
+};
+
+// 被测物体的屏幕空间矩形（深度缓冲像素，含端点）与最近深度
+struct OccludeeRect {
+    int x0, y0, x1, y1;
+    float depth;
+};
+
+// 软件遮挡剔除：遮挡体光栅化到低分辨率深度缓冲，物体以屏幕空间包围矩形的最近深度与之比较
+// - 深度为 NDC z 映射到 [0, 1]，越小越近；清空为 1
+// - 缓冲按行切成 kBands 个条带，各条带由线程池并行光栅化（SSE2 一次 4 个像素），互不写同一像素
+// - 光栅化后为每个 kBlockSize × kBlockSize 块记录最远深度（层级深度），测试时先按块比较，块级无法判定再逐像素比较
+// - 遮挡体按像素中心覆盖写入（与 GPU 光栅化规则一致），被测矩形取其触及的像素并向外扩一像素；
+//   与近平面相交的遮挡体三角形直接丢弃，与近平面相交的被测物体视为可见
+class OcclusionBuffer {
+public:
+    static const int kWidth = 256;
+    static const int kHeight = 128;
+    static const int kBands = 8;
+    static const int kBlockSize = 8;
+
+    OcclusionBuffer();
+
+    // 清空后光栅化 count 个遮挡体实例：mvps[i] 为第 i 个实例的模型到裁剪空间矩阵
+    void render(const OccluderMesh& mesh, const glm::mat4* mvps, size_t count, ThreadPool& pool);
+
+    // 世界空间 AABB（中心 ± 半长）投影到屏幕；与近平面相交或完全在屏幕外时返回 false
+    static bool projectBox(const glm::vec3& center, const glm::vec3& extent, const glm::mat4& viewProj,
+                           OccludeeRect& rect);
+    // 矩形内所有像素都有比 rect.depth 更近的遮挡体时返回 true
+    bool occluded(const OccludeeRect& rect) const;
+
+    // 批量测试 boxes 中 visible[i] 非 0 的物体，被遮挡者置 0，返回被遮挡个数
+    unsigned cullBoxes(const BoxArrays& boxes, const glm::mat4& viewProj, uint8_t* visible) const;
+
+    size_t trianglesRasterized() const { return rasterized_; }
+
+private:
+    // 屏幕空间三角形：顶点为像素坐标，深度按平面 z = z0 + dzdx * x + dzdy * y 插值
+    struct ScreenTriangle {
+        float x[3], y[3];
+        float z0, dzdx, dzdy;
+        int minX, maxX, minY, maxY;
+    };
+
+    void rasterizeBand(int band);
+    void buildBlocks(int band);
+
+    std::vector<glm::vec4> clip_; // 各实例变换后的裁剪空间顶点
+    std::vector<float> depth_;  // kWidth × kHeight
+    std::vector<float> blocks_; // 每块的最远深度
+    std::vector<ScreenTriangle> triangles_;
+    std::vector<uint8_t> accepted_; // 与 triangles_ 对应：0 = 与近平面相交 / 退化 / 不覆盖任何像素中心
+    size_t rasterized_;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "transform.h"
+
+// 累计统计，按秒输出后清零
+struct OcclusionQueryStats {
+    unsigned frames;
+    unsigned issued;             // 发出的包围盒查询
+    unsigned results;            // 收取的结果
+    unsigned skipped;            // 已知被遮挡、CPU 不提交的绘制
+    unsigned conditional;        // 以未收取的查询为条件提交的绘制
+    unsigned conditionalSkipped; // 其中条件查询结果为被遮挡（GPU 跳过）的绘制
+
+    // 输出一行每帧平均值（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+};
+
+// 硬件遮挡查询（逐物体，适合几何较重的独立物体）：
+// - 不透明物体绘制完后，对需要查询的物体绘制模型空间包围盒（略放大），只做深度测试、不写颜色与深度，
+//   以 GL_ANY_SAMPLES_PASSED_CONSERVATIVE（不支持时 GL_ANY_SAMPLES_PASSED）查询是否有样本通过
+// - 结果延迟到之后的帧不等待地收取：下一帧若结果已到，被遮挡的物体由 CPU 直接跳过；
+//   未到则以该查询为条件提交绘制（glBeginConditionalRender），由 GPU 按结果跳过，CPU 不阻塞
+// - 时间一致性：被遮挡的物体每帧重新查询，可见的物体隔 kRequeryInterval 帧以上（按物体下标错开）才再查询
+// - 包围盒与近平面相交的物体视为可见，不查询（盒子被近平面裁掉后结果不可靠）
+class OcclusionQueries {
+public:
+    static const unsigned kRequeryInterval = 8;
+
+    OcclusionQueries();
+    ~OcclusionQueries();
+
+    // 编译包围盒程序并建立 [boundsMin, boundsMax] 的包围盒几何，为 objectCount 个物体各分配一个查询
+    bool create(const std::string& shaderDir, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                size_t objectCount);
+    bool ready() const { return vao_ != 0; }
+
+    // 帧开始：收取已完成的查询（GL_QUERY_RESULT_AVAILABLE，不等待）
+    void beginFrame();
+    // 物体 object 本帧是否提交绘制；candidate 为其通过了视锥等剔除。
+    // 返回 true 时 condition 为条件渲染所用的查询（0 = 无条件绘制）
+    bool select(size_t object, bool candidate, GLuint& condition);
+    // 不透明物体绘制之后调用：为本帧的候选物体中到期且没有未完成查询者发出查询
+    void issue(const ObjectTransform* transforms, size_t count);
+
+    const OcclusionQueryStats& stats() const { return stats_; }
+    void resetStats() { stats_ = OcclusionQueryStats(); }
+
+private:
+    OcclusionQueries(const OcclusionQueries&);
+    OcclusionQueries& operator=(const OcclusionQueries&);
+
+    struct ObjectState {
+        GLuint query;
+        bool candidate;     // 本帧通过了视锥等剔除
+        bool pending;       // 查询已发出、结果未收取
+        bool valid;         // 最近的查询结果仍适用（离开候选后失效，重新进入时先照常绘制）
+        bool visible;       // 最近收取的结果
+        unsigned nextQuery; // 下次查询的帧号
+        unsigned conditionalDraws; // 以未收取的查询为条件提交的绘制数
+    };
+
+    static bool crossesNearPlane(const glm::mat4& mvp, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    Shader shader_;
+    Uniform<glm::mat4> mvpUniform_;
+    GLuint vao_, vbo_, ebo_;
+    glm::vec3 boundsMin_, boundsMax_;
+    std::vector<ObjectState> objects_;
+    unsigned frame_;
+    OcclusionQueryStats stats_;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "glstate.h"
+#include "shader.h"
+#include "uniformblocks.h"
+
+// 64 位排序键，高位优先：pass 4 | program 12 | material 8 | vao 12 | depth 24 | 保留 4
+// 同一 pass 内按程序、材质、VAO 聚合，最后按深度由近到远（不透明物体减少过度绘制）
+enum RenderPass {
+    RENDER_PASS_OPAQUE = 0,
+    RENDER_PASS_OPAQUE_LATE,  // GPU 剔除的第二阶段：在本帧深度金字塔建立之后绘制（见 gpuculling.h）
+    RENDER_PASS_COUNT = 16
+};
+
+const int kSortKeyProgramBits = 12;
+const int kSortKeyMaterialBits = 8;
+const int kSortKeyVaoBits = 12;
+const int kSortKeyDepthBits = 24;
+
+// depth 为归一化到 [0, 1] 的视空间距离，超出范围时截断
+uint64_t makeSortKey(unsigned pass, unsigned program, unsigned material, unsigned vao, float depth);
+
+// 一次绘制调用的参数
+// - indexType 为 0 时为非索引绘制（first / count），否则 count 个索引从 indexOffset 字节处开始
+// - instances > 1 时使用实例化绘制
+// - drawCount > 0 时为 glMultiDrawElements，各段由 counts / offsets 给出（调用方保证在执行前有效）
+// - indirectCount > 0 时为 glMultiDrawElementsIndirect，命令从当前 GL_DRAW_INDIRECT_BUFFER 的 commandOffset 字节处开始
+struct DrawCommand {
+    GLenum mode;
+    GLenum indexType;
+    GLint first;
+    GLsizei count;
+    uintptr_t indexOffset;
+    GLsizei instances;
+    const GLsizei* counts;
+    const void* const* offsets;
+    GLsizei drawCount;
+    uintptr_t commandOffset;
+    GLsizei indirectCount;
+};
+
+DrawCommand arrayDraw(GLenum mode, GLint first, GLsizei count, GLsizei instances = 1);
+DrawCommand indexedDraw(GLenum mode, GLenum indexType, GLsizei count, uintptr_t indexOffset, GLsizei instances = 1);
+DrawCommand multiIndexedDraw(GLenum mode, GLenum indexType, const GLsizei* counts, const void* const* offsets,
+                             GLsizei drawCount);
+DrawCommand indirectDraw(GLenum mode, GLenum indexType, uintptr_t commandOffset, GLsizei commandCount);
+void issueDraw(const DrawCommand& draw);
+
+struct RenderItem {
+    uint64_t key;
+    Shader* shader;
+    GLuint vao;
+    unsigned material; // 材质 uniform 缓冲中的实例下标
+    unsigned object;   // 调用方逐物体数据的下标
+    DrawCommand draw;
+    GLuint condition;  // 非 0 时在以该遮挡查询为条件的条件渲染中绘制（GL_QUERY_WAIT，由 GPU 等待结果）
+};
+
+// 一帧内相邻绘制间的状态切换次数
+struct RenderQueueStats {
+    unsigned draws;
+    unsigned programChanges;
+    unsigned materialChanges;
+    unsigned vaoChanges;
+};
+
+// 渲染队列：每帧 clear 后提交绘制项，sort 按键基数排序，execute 按序设置状态并绘制
+class RenderQueue {
+public:
+    RenderQueue() { resetStats(); }
+
+    void clear();
+    // 绘制项的程序下标（排序键的 program 字段）：同一 Shader 在队列生命周期内不变
+    unsigned programIndex(const Shader* shader);
+    void submit(const RenderItem& item);
+    // LSD 基数排序（每趟 8 位，所有键该位相同的趟跳过），相同键保持提交顺序
+    void sort();
+
+    size_t size() const { return items_.size(); }
+    const RenderItem& operator[](size_t i) const { return items_[order_[i]]; }
+
+    // 按排序后的顺序执行；程序、材质、VAO 只在与上一项不同时切换。
+    // setObject(item, programChanged) 在绘制前设置逐物体 uniform
+    template <typename F>
+    void execute(const UniformBuffer& materials, F setObject) {
+        execute(materials, setObject, 0, RENDER_PASS_COUNT - 1);
+    }
+    // 只执行 pass 在 [firstPass, lastPass] 内的绘制项（排序后各 pass 连续）
+    template <typename F>
+    void execute(const UniformBuffer& materials, F setObject, unsigned firstPass, unsigned lastPass) {
+        const Shader *program = NULL;
+        unsigned material = ~0u;
+        for (size_t i = 0; i < order_.size(); ++i) {
+            const RenderItem &item = items_[order_[i]];
+            unsigned pass = static_cast<unsigned>(item.key >> 60);
+            if (pass < firstPass || pass > lastPass) continue;
+            bool programChanged = item.shader != program;
+            if (programChanged) {
+                item.shader->use();
+                program = item.shader;
+            }
+            if (item.material != material) {
+                materials.bind(item.material);
+                material = item.material;
+            }
+            glState().bindVertexArray(item.vao);
+            setObject(item, programChanged);
+            if (item.condition) glBeginConditionalRender(item.condition, GL_QUERY_WAIT);
+            issueDraw(item.draw);
+            if (item.condition) glEndConditionalRender();
+        }
+    }
+
+    // 累计的每帧状态切换：sorted 为执行顺序，submitted 为提交顺序（用于对比排序收益）
+    const RenderQueueStats& sortedStats() const { return sorted_; }
+    const RenderQueueStats& submittedStats() const { return submitted_; }
+    unsigned frames() const { return frames_; }
+    // 输出一行两种顺序下的每帧平均切换次数（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+    void resetStats();
+
+private:
+    RenderQueue(const RenderQueue&);
+    RenderQueue& operator=(const RenderQueue&);
+
+    static void countChanges(const std::vector<RenderItem>& items, const std::vector<uint32_t>& order,
+                             RenderQueueStats& stats);
+
+    std::vector<RenderItem> items_;
+    std::vector<uint32_t> order_;
+    std::vector<uint64_t> keys_, keysTmp_;
+    std::vector<uint32_t> orderTmp_;
+    std::vector<const Shader*> programs_;
+    RenderQueueStats sorted_, submitted_;
+    unsigned frames_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+#include <glad/glad.h>
+
+// 帧区域内的一块分配：data 为持久映射的写入地址，offset 为其在 buffer 中的字节偏移；空间不足时 data 为 NULL
+struct RingAllocation {
+    GLuint buffer;
+    size_t offset;
+    void* data;
+};
+
+// 累计统计：stall 为轮到某帧区域时 GPU 仍未读完、CPU 必须等待的次数
+struct RingStats {
+    unsigned frames;
+    unsigned stalls;
+    double waitMs;
+    size_t bytes;
+
+    // 输出一行每帧平均用量与等待（没有统计的帧时不输出）
+    void report(std::ostream& out) const;
+};
+
+// 每帧动态数据（uniform 块、实例数据）的环形上传缓冲
+// - 一块 glBufferStorage 不可变存储以 GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT 一次映射，
+//   写入即对 GPU 可见，不再调用 glBufferData / glBufferSubData（不会隐式同步或重新分配）
+// - 均分为 kFrameRegions 个帧区域，每帧在一个区域内按对齐要求线性分配
+// - endFrame 在本帧读取该区域的绘制之后插入 fence，下次轮到该区域时 beginFrame 先等待它
+// - 驱动不支持 buffer storage 时 create 返回 false，调用方回退到原有的上传方式
+class DynamicRingBuffer {
+public:
+    static const int kFrameRegions = 3;
+
+    DynamicRingBuffer();
+    ~DynamicRingBuffer();
+
+    bool create(size_t frameBytes);
+    bool valid() const { return mapped_ != NULL; }
+
+    // 切换到下一帧区域并清空其分配
+    void beginFrame();
+    // alignment 须为 2 的幂
+    RingAllocation allocate(size_t bytes, size_t alignment);
+    // 按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐，可直接用于 glBindBufferRange
+    RingAllocation allocateUniform(size_t bytes) { return allocate(bytes, uniformAlignment_); }
+    void endFrame();
+
+    GLuint buffer() const { return buffer_; }
+    size_t frameBytes() const { return frameBytes_; }
+    RingStats stats() const { return stats_; }
+    void resetStats();
+
+private:
+    DynamicRingBuffer(const DynamicRingBuffer&);
+    DynamicRingBuffer& operator=(const DynamicRingBuffer&);
+
+    GLuint buffer_;
+    unsigned char* mapped_;
+    size_t frameBytes_;
+    size_t uniformAlignment_;
+    int region_;
+    size_t used_;
+    GLsync fences_[kFrameRegions];
+    RingStats stats_;
+};
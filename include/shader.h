@@ -4,30 +4,175 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+// Typed handle to an active uniform of a particular Shader.
+// An invalid handle (the program has no such active uniform, or its GLSL type
+// does not match T) is accepted by Shader::set and ignored.
+template <typename T>
+struct Uniform {
+    int slot;
+    Uniform() : slot(-1) {}
+    explicit Uniform(int s) : slot(s) {}
+    bool valid() const { return slot >= 0; }
+};
+
+// GLSL type expected for each handle type
+template <typename T> struct UniformType;
+template <> struct UniformType<int> { static const GLenum value = GL_INT; };
+template <> struct UniformType<float> { static const GLenum value = GL_FLOAT; };
+template <> struct UniformType<glm::vec3> { static const GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::mat3> { static const GLenum value = GL_FLOAT_MAT3; };
+template <> struct UniformType<glm::mat4> { static const GLenum value = GL_FLOAT_MAT4; };
+
+// Uniform upload counters, accumulated over all shaders until reset
+struct UniformStats {
+    unsigned issued;  // glUniform* calls made
+    unsigned skipped; // value unchanged, or not an active uniform of the program
+
+    // One "Uniforms:" line with per-frame averages over `frames` frames
+    void report(std::ostream& out, unsigned frames) const;
+};
 
 class Shader {
 public:
     unsigned int ID;
 
-    // Construct a shader program from vertex and fragment shader file paths
+    Shader();
+    // Construct a shader program from vertex and fragment shader file paths (blocks until linked)
     Shader(const std::string& vertexPath, const std::string& fragmentPath);
     ~Shader();
 
-    // Activate the shader program
+    // Issue compilation and linking without waiting for the driver; a valid cached
+    // binary is loaded instead, in which case the program is linked on return.
+    // Each entry of `defines` ("NAME" or "NAME VALUE") is injected as a #define.
+    void compile(const std::string& vertexPath, const std::string& fragmentPath,
+                 const std::vector<std::string>& defines = std::vector<std::string>());
+    // Issue compilation of one stage as a separable program (GL_PROGRAM_SEPARABLE), to be
+    // combined with other stages by linkPipeline. `source` is the complete text (readFile);
+    // `path` names the log label and the binary cache entry.
+    void compileStage(GLenum type, const std::string& path, const std::string& source);
+    // Combine a vertex and a fragment stage (compileStage) into a program pipeline. Stages may
+    // be shared by several pipelines and must outlive them; uniforms looked up and set through
+    // the pipeline are forwarded to the stages that declare them.
+    void linkPipeline(Shader& vertexStage, Shader& fragmentStage);
+    // True when finish() will not stall: the program is not pending, or the driver reports
+    // completion (GL_KHR_parallel_shader_compile). Without the extension always true.
+    bool ready() const;
+    // Wait for the link, report errors, store the binary and reflect uniforms
+    bool finish();
+    bool pending() const { return state_ == SHADER_COMPILING; }
+    bool linked() const { return state_ == SHADER_READY; }
+
+    // Activate the shader program (or bind the pipeline)
     void use() const;
 
-    // Utility uniform functions (minimal set)
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, int value) const;
-    void setFloat(const std::string &name, float value) const;
-    void setMat4(const std::string &name, const glm::mat4 &mat) const;
-    void setVec3(const std::string &name, const glm::vec3 &vec) const;
+    // Look up an active uniform once (after linking, all active uniforms are reflected)
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const {
+        return Uniform<T>(findUniform(name, UniformType<T>::value));
+    }
+
+    // Upload through a handle; the program must be in use. Values equal to the
+    // last one uploaded to this program are skipped.
+    void set(Uniform<int> u, int value);
+    void set(Uniform<float> u, float value);
+    void set(Uniform<glm::vec3> u, const glm::vec3& value);
+    void set(Uniform<glm::mat3> u, const glm::mat3& value);
+    void set(Uniform<glm::mat4> u, const glm::mat4& value);
+
+    // Utility uniform functions by name (reflected table lookup, same shadowing)
+    void setBool(const std::string &name, bool value);
+    void setInt(const std::string &name, int value);
+    void setFloat(const std::string &name, float value);
+    void setMat4(const std::string &name, const glm::mat4 &mat);
+    void setVec3(const std::string &name, const glm::vec3 &vec);
+
+    // Assign a binding point to a uniform block; ignored if the program has no such block
+    void bindUniformBlock(const std::string& name, GLuint binding);
+
+    // On-disk program binary cache (<vertex shader>.glprog), on by default;
+    // used only when the driver exposes at least one program binary format
+    static void setBinaryCacheEnabled(bool enabled) { binaryCacheEnabled_ = enabled; }
+
+    static UniformStats uniformStats() { return stats_; }
+    static void resetUniformStats() { stats_.issued = stats_.skipped = 0; }
+
+    // Source text with each of `defines` that the source mentions injected after #version;
+    // unreferenced defines are left out so they do not split otherwise identical stages.
+    // Vertex (.vs) and fragment (.fs) stages also get the shared common.glsl from the same
+    // directory, inserted after the defines
+    static std::string readFile(const std::string& path,
+                                const std::vector<std::string>& defines = std::vector<std::string>());
 
 private:
-    static std::string readFile(const std::string& path);
+    // Reflected active uniform with a shadow copy of the last uploaded value
+    struct UniformInfo {
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint size;
+        bool hasValue;
+        unsigned char value[sizeof(glm::mat4)];
+    };
+
+    enum State { SHADER_EMPTY, SHADER_COMPILING, SHADER_READY, SHADER_FAILED };
+    enum { kVertexStage, kFragmentStage, kPipelineStages };
+
+    // A pipeline uniform's slot in each stage (-1 where the stage does not declare it)
+    struct UniformRoute {
+        int slot[kPipelineStages];
+    };
+
+    bool loadCached();
+    void link();
+    bool finishPipeline();
+    void routeUniforms();
+    template <typename T>
+    void setStages(Uniform<T> u, const T& value) {
+        if (u.slot < 0) {
+            ++stats_.skipped;
+            return;
+        }
+        const UniformRoute &r = routes_[u.slot];
+        for (int s = 0; s < kPipelineStages; ++s) {
+            if (r.slot[s] >= 0) stages_[s]->set(Uniform<T>(r.slot[s]), value);
+        }
+    }
+    bool loadBinary(const std::string& path, uint64_t key);
+    bool saveBinary(const std::string& path, uint64_t key) const;
+    void reflectUniforms();
+    int findUniform(const std::string& name, GLenum type) const;
+    // Returns true when the value differs from the shadow copy (which is then updated)
+    bool changed(int slot, const void* value, size_t bytes);
+
+    // Compile state between compile() and finish()
+    State state_;
+    unsigned int vShader_, fShader_;
+    std::string label_;
+    std::string cachePath_;
+    uint64_t key_;
+    bool useCache_;
+    bool separable_;
+    std::chrono::steady_clock::time_point start_;
+
+    // Program pipeline state (linkPipeline); the stages are owned elsewhere
+    GLuint pipeline_;
+    Shader* stages_[kPipelineStages];
+    std::vector<UniformRoute> routes_;
+
+    std::vector<UniformInfo> uniforms_;
+    std::unordered_map<std::string, int> uniformSlots_;
+    static UniformStats stats_;
+    static bool binaryCacheEnabled_;
+
     static unsigned int compileShader(GLenum type, const std::string& source);
+    static void checkShader(unsigned int shader, GLenum type);
 };
 
 #endif // SHADER_H
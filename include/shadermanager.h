@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+struct MaterialBlock;
+
+// Shading models, in argv[2] / number key order
+enum ShadingModel {
+    SHADING_PHONG,
+    SHADING_GOURAUD,
+    SHADING_COOK_TORRANCE,
+    kShadingModelCount
+};
+
+// Compile-time shader features, injected into the sources as #defines
+enum ShaderFeature {
+    SHADER_METALLIC_ONLY = 1 << 0,   // Cook-Torrance, metallic == 1: F0 = albedo, no diffuse term
+    SHADER_DIELECTRIC_ONLY = 1 << 1, // Cook-Torrance, metallic == 0: F0 = 0.04
+    SHADER_NO_SPECULAR = 1 << 2,     // Phong / Gouraud, specular == 0
+    SHADER_FAST_FRESNEL = 1 << 3,    // Cook-Torrance: Spherical Gaussian Schlick (approximate)
+    SHADER_INSTANCED = 1 << 4,       // per-instance transforms and material index (instancing.h)
+    SHADER_VERTEX_NORMAL_MATRIX = 1 << 5, // normal matrix inverted per vertex instead of the CPU one
+    kShaderFeatureCount = 6
+};
+
+// Cheapest feature set that renders `material` exactly with `model`; `optIn` adds the opt-in
+// features the model supports: inexact ones (SHADER_FAST_FRESNEL) and the
+// SHADER_VERTEX_NORMAL_MATRIX comparison mode
+unsigned shaderFeaturesFor(ShadingModel model, const MaterialBlock& material, unsigned optIn = 0);
+// Features exact for every one of `count` materials (e.g. an instanced material table)
+unsigned shaderFeaturesFor(ShadingModel model, const MaterialBlock* materials, unsigned count,
+                           unsigned optIn = 0);
+
+// Owns one program per (shading model, feature bitmask) permutation and builds each only when needed.
+// - get() compiles on first use and blocks until that one program is linked
+// - warm() queues programs to be built in the background by update(): with
+//   GL_KHR_parallel_shader_compile all queued compiles are issued at once and each is
+//   finalized when the driver reports completion; without it one program is built per frame
+// - linked programs get the shared uniform block bindings (bindUniformBlocks)
+// - with separable programs (GL 4.1 / GL_ARB_separate_shader_objects) each permutation is a
+//   program pipeline, and stages with identical source text are compiled once and shared
+class ShaderManager {
+public:
+    explicit ShaderManager(const std::string& shaderDir, bool separable = true);
+
+    Shader& get(ShadingModel model, unsigned features = 0);
+    void warm(ShadingModel model, unsigned features = 0);
+    void update();
+
+    // No programs queued or compiling
+    bool idle() const;
+
+    bool separable() const { return separable_; }
+    size_t programCount() const { return programs_.size(); }
+    // Distinct compiled stages (two per program when not separable)
+    size_t stageCount() const { return separable_ ? stages_.size() : 2 * programs_.size(); }
+
+    static const char* name(ShadingModel model);
+    // "cooktorrance [METALLIC_ONLY]"
+    static std::string describe(ShadingModel model, unsigned features);
+
+private:
+    ShaderManager(const ShaderManager&);
+    ShaderManager& operator=(const ShaderManager&);
+
+    struct Program {
+        Shader shader;
+        ShadingModel model;
+        unsigned features;
+        bool queued;
+        bool bound;
+    };
+
+    Program& program(ShadingModel model, unsigned features);
+    void start(Program& p);
+    void finalize(Program& p);
+    // Separable program for a stage source, compiled on first request
+    Shader& stage(GLenum type, const std::string& path, const std::vector<std::string>& defines);
+
+    std::string dir_;
+    bool separable_;
+    // Keyed by source hash; declared before programs_ so the pipelines are destroyed first
+    std::map<uint64_t, std::unique_ptr<Shader> > stages_;
+    std::map<unsigned, std::unique_ptr<Program> > programs_;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "mesh.h"
+
+// 默认 LOD 链：相对完整网格的三角形比例
+const float kLodRatios[] = {0.5f, 0.25f, 0.125f, 0.06f};
+const size_t kLodRatioCount = sizeof(kLodRatios) / sizeof(kLodRatios[0]);
+
+// 基于二次误差度量（Garland-Heckbert）的半边折叠简化
+// - 只把顶点折叠到相邻的已有顶点，结果索引与原网格共享顶点缓冲
+// - 边界顶点（开放边）与属性接缝顶点（同一位置多个法线）锁定不动
+// - 折叠代价 = 位置二次误差 + 法线差异（按边长缩放为距离量纲），会翻转三角形的折叠被拒绝
+// - 尽量简化到 targetIndexCount 以内，返回结果相对原网格的几何误差（模型空间距离）
+float simplifyMesh(const Mesh& mesh, const std::vector<unsigned int>& indices, size_t targetIndexCount,
+                   std::vector<unsigned int>& out);
+
+// 以 mesh.indices 为 LOD 0 生成 LOD 链：各级在线程池上并行地从完整网格简化，
+// 再做顶点缓存重排，结果追加到 mesh.indices 并记录在 mesh.lods
+// - 与上一级相比三角形减少不足 10% 的级别被丢弃
+// - 最多 kMaxLods 级（含 LOD 0）
+void buildLodChain(Mesh& mesh, const float* ratios, size_t ratioCount);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 固定大小的工作线程池
+// - parallelFor 的调用线程也参与执行，因此在任务内部嵌套调用不会死锁
+class ThreadPool {
+public:
+    // threads = 0 时使用 std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    // 参与计算的线程总数（含调用线程）
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // 投递一个异步任务
+    void submit(const std::function<void()>& task);
+
+    // 对 [0, count) 并行执行 fn(i)，全部完成后返回；maxThreads = 0 表示不限制
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned maxThreads = 0);
+
+    // 进程级共享线程池（首次使用时创建）
+    static ThreadPool& shared();
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()> > tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+};
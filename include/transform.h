@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+// 逐物体变换：每次绘制在 CPU 上计算一次，顶点着色器直接使用，不再逐顶点求逆
+struct ObjectTransform {
+    glm::mat4 mvp;
+    glm::mat4 model;
+    glm::mat3 normal; // 法线矩阵 transpose(inverse(mat3(model)))
+};
+
+// 法线矩阵：由 mat3(model) 三列的叉积得到余子式矩阵，再除以行列式（保留镜像变换的符号）；
+// 奇异矩阵时直接返回余子式矩阵
+glm::mat3 normalMatrix(const glm::mat4& model);
+
+// 批量计算 count 个物体的变换（viewProj = proj * view），多物体时一帧一次调用
+void computeTransforms(const glm::mat4& viewProj, const glm::mat4* models, size_t count, ObjectTransform* out);
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Shader;
+
+// Fixed binding points of the uniform blocks shared by all programs
+const GLuint kFrameBlockBinding = 0;
+const GLuint kLightBlockBinding = 1;
+const GLuint kMaterialBlockBinding = 2;
+const GLuint kMaterialTableBinding = 3;
+const GLuint kCullBlockBinding = 4;
+
+// C++ mirrors of the std140 blocks declared in src/shader/*.vs|fs.
+// A vec3 is 16-byte aligned in std140, so a following float packs into its fourth component.
+
+// layout(std140) uniform FrameBlock { mat4 uView; mat4 uProj; vec3 uViewPos; };
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 viewPos;
+    float pad0;
+};
+
+// layout(std140) uniform LightBlock { vec3 uLightPos; vec3 uLightColor; };
+struct LightBlock {
+    glm::vec3 position;
+    float pad0;
+    glm::vec3 color;
+    float pad1;
+};
+
+// layout(std140) uniform MaterialBlock {
+//     vec3 uObjectColor; float uAmbient; vec3 uAlbedo; float uRoughness;
+//     vec3 F0; float uMetallic; float uSpecular; float uShininess; };
+struct MaterialBlock {
+    glm::vec3 objectColor; // Phong / Gouraud base color
+    float ambient;
+    glm::vec3 albedo;      // Cook-Torrance base color
+    float roughness;
+    glm::vec3 F0;
+    float metallic;
+    float specular;
+    float shininess;
+    float pad0[2];
+};
+
+// Instanced variants (INSTANCED) index a table of materials per instance:
+// layout(std140) uniform MaterialTable { Material uMaterials[8]; };
+// where Material has the MaterialBlock members. A std140 struct array element is
+// rounded up to 16 bytes, which MaterialBlock already is.
+const unsigned kMaxInstanceMaterials = 8;
+
+struct MaterialTableBlock {
+    MaterialBlock materials[kMaxInstanceMaterials];
+};
+
+// Parameters of the GPU culling compute shader (src/shader/gpucull.comp):
+// layout(std140) uniform CullBlock {
+//     mat4 uViewProj; mat4 uObjectModel; vec4 uObjectNormal[3]; vec4 uPlanes[6];
+//     vec4 uBoundsCenter; vec4 uBoundsExtent; vec4 uCamera;
+//     vec4 uLodError[2]; vec2 uViewport; float uLodThreshold; uint uInstanceCount;
+//     uint uLodCount; uint uInputBase; uint uInputCapacity; uint uHiZLevels; };
+struct CullBlock {
+    glm::mat4 viewProj;
+    glm::mat4 objectModel;   // Model matrix shared by all instances, applied before each placement
+    glm::vec4 objectNormal[3]; // Its normal matrix, one mat3 column per vec4
+    glm::vec4 planes[6];     // Frustum planes (xyz normal pointing inside, w distance)
+    glm::vec4 boundsCenter;  // Model-space AABB center; w is the bounding sphere radius
+    glm::vec4 boundsExtent;  // Model-space AABB half extent
+    glm::vec4 camera;        // World-space eye; w is the viewport height / (2 tan(fovy / 2))
+    glm::vec4 lodError[2];   // MeshLod::error of up to kMaxLods levels, four per vec4
+    glm::vec2 viewport;      // Depth pyramid level 0 size in pixels
+    float lodThreshold;      // Allowed screen-space error in pixels
+    uint32_t instanceCount;
+    uint32_t lodCount;       // Draw commands per phase (1 when LODs are not selected)
+    uint32_t inputBase;      // Start of the input instance data, in 4-byte words
+    uint32_t inputCapacity;  // Instances per section of the input InstanceBuffer
+    uint32_t hizLevels;
+};
+
+static_assert(offsetof(FrameBlock, view) == 0, "FrameBlock::view std140 offset");
+static_assert(offsetof(FrameBlock, proj) == 64, "FrameBlock::proj std140 offset");
+static_assert(offsetof(FrameBlock, viewPos) == 128, "FrameBlock::viewPos std140 offset");
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock std140 size");
+
+static_assert(offsetof(LightBlock, position) == 0, "LightBlock::position std140 offset");
+static_assert(offsetof(LightBlock, color) == 16, "LightBlock::color std140 offset");
+static_assert(sizeof(LightBlock) == 32, "LightBlock std140 size");
+
+static_assert(offsetof(MaterialBlock, objectColor) == 0, "MaterialBlock::objectColor std140 offset");
+static_assert(offsetof(MaterialBlock, ambient) == 12, "MaterialBlock::ambient std140 offset");
+static_assert(offsetof(MaterialBlock, albedo) == 16, "MaterialBlock::albedo std140 offset");
+static_assert(offsetof(MaterialBlock, roughness) == 28, "MaterialBlock::roughness std140 offset");
+static_assert(offsetof(MaterialBlock, F0) == 32, "MaterialBlock::F0 std140 offset");
+static_assert(offsetof(MaterialBlock, metallic) == 44, "MaterialBlock::metallic std140 offset");
+static_assert(offsetof(MaterialBlock, specular) == 48, "MaterialBlock::specular std140 offset");
+static_assert(offsetof(MaterialBlock, shininess) == 52, "MaterialBlock::shininess std140 offset");
+static_assert(sizeof(MaterialBlock) == 64, "MaterialBlock std140 size");
+static_assert(offsetof(CullBlock, objectModel) == 64, "CullBlock::objectModel std140 offset");
+static_assert(offsetof(CullBlock, objectNormal) == 128, "CullBlock::objectNormal std140 offset");
+static_assert(offsetof(CullBlock, planes) == 176, "CullBlock::planes std140 offset");
+static_assert(offsetof(CullBlock, boundsCenter) == 272, "CullBlock::boundsCenter std140 offset");
+static_assert(offsetof(CullBlock, camera) == 304, "CullBlock::camera std140 offset");
+static_assert(offsetof(CullBlock, lodError) == 320, "CullBlock::lodError std140 offset");
+static_assert(offsetof(CullBlock, viewport) == 352, "CullBlock::viewport std140 offset");
+static_assert(offsetof(CullBlock, instanceCount) == 364, "CullBlock::instanceCount std140 offset");
+static_assert(offsetof(CullBlock, hizLevels) == 380, "CullBlock::hizLevels std140 offset");
+static_assert(sizeof(CullBlock) == 384, "CullBlock std140 size");
+static_assert(sizeof(MaterialTableBlock) == 64 * kMaxInstanceMaterials, "MaterialTableBlock std140 size");
+
+// Assign the fixed binding points to the blocks a program declares
+void bindUniformBlocks(Shader& shader);
+
+// A uniform buffer holding `count` instances of one block, each aligned to
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT so any instance can be bound with glBindBufferRange.
+// Updates equal to the last upload of an instance are skipped.
+class UniformBuffer {
+public:
+    UniformBuffer() : buffer_(0), binding_(0), blockSize_(0), stride_(0), count_(0) {}
+    ~UniformBuffer();
+
+    void create(GLuint binding, size_t blockSize, unsigned count = 1);
+
+    // Upload instance `index`; returns false when unchanged
+    bool update(unsigned index, const void* block);
+    template <typename T>
+    bool update(unsigned index, const T& block) { return update(index, static_cast<const void*>(&block)); }
+
+    // Bind instance `index` to the buffer's binding point
+    void bind(unsigned index = 0) const;
+
+private:
+    UniformBuffer(const UniformBuffer&);
+    UniformBuffer& operator=(const UniformBuffer&);
+
+    GLuint buffer_;
+    GLuint binding_;
+    size_t blockSize_;
+    size_t stride_;
+    unsigned count_;
+    std::vector<unsigned char> shadow_;
+    std::vector<bool> uploaded_;
+};
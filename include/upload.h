@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include <glad/glad.h>
+
+// 分帧上传：把大块数据按固定大小分片，用 glBufferSubData 在每帧的时间预算内逐步写入
+// - add() 立即用 glBufferData(NULL) 分配存储，数据需在上传完成前保持有效
+// - 通过 GL_COPY_WRITE_BUFFER 绑定点上传，不影响 VAO 与其他绑定
+class UploadQueue {
+public:
+    static const size_t kChunkBytes = 256 * 1024;
+
+    UploadQueue() : bytesUploaded_(0) {}
+
+    void add(GLuint buffer, const void* data, size_t bytes);
+
+    // 上传直到用完 budgetMs（至少一片），返回本次上传的字节数
+    size_t step(double budgetMs);
+
+    bool empty() const { return pending_.empty(); }
+    size_t bytesUploaded() const { return bytesUploaded_; }
+
+private:
+    struct Pending {
+        GLuint buffer;
+        const unsigned char* data;
+        size_t bytes;
+        size_t offset;
+    };
+    std::deque<Pending> pending_;
+    size_t bytesUploaded_;
+};
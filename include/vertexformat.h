@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// GPU 顶点格式
+// - VERTEX_FLOAT32:    pos 3×float + normal 3×float，24 字节
+// - VERTEX_Q16_OCT16:  pos 3×unorm16（相对包围盒）+ 2 字节填充 + 八面体法线 2×snorm16，12 字节
+// - VERTEX_Q16_PACKED: pos 3×unorm16 + 2 字节填充 + 法线 GL_INT_2_10_10_10_REV，12 字节
+// 量化位置在顶点着色器中以 uPosScale / uPosOffset 反量化，
+// 八面体法线由 uNormalEncoding = 1 指示解码
+enum VertexFormat {
+    VERTEX_FLOAT32 = 0,
+    VERTEX_Q16_OCT16,
+    VERTEX_Q16_PACKED,
+};
+
+// 解析 "float" / "q16-oct16" / "q16-packed"，无法识别时返回 false
+bool parseVertexFormat(const std::string& name, VertexFormat& out);
+const char* vertexFormatName(VertexFormat format);
+
+// 格式对应的顶点布局
+VertexLayout vertexLayout(VertexFormat format);
+
+// 着色器中 uNormalEncoding 的取值：0 = 直接使用 xyz，1 = 八面体解码 xy
+int normalEncoding(const VertexLayout& layout);
+
+// 八面体法线编码 / 解码，编码结果位于 [-1, 1]²
+glm::vec2 octEncode(const glm::vec3& n);
+glm::vec3 octDecode(const glm::vec2& e);
+
+// 量化误差（反量化后与原始数据比较）
+struct QuantizationError {
+    float position;      // 最大绝对误差（模型空间单位）
+    float positionRel;   // 相对包围盒最大边长
+    float normalDegrees; // 最大法线夹角（度）
+};
+
+// 打包后顶点 / 索引数据的存储
+struct PackedMesh {
+    std::vector<unsigned char> vertices; // VERTEX_FLOAT32 时为空，直接引用 Mesh::vertices
+    std::vector<unsigned char> indices;
+};
+
+// 按格式打包网格并构造上传视图；视图引用 mesh 与 packed，需保持其有效
+// - error 非空时输出实测量化误差
+MeshBuffers packMesh(const Mesh& mesh, VertexFormat format, PackedMesh& packed,
+                     QuantizationError* error = nullptr);
@@ -0,0 +1,75 @@
+#include "asyncloader.h"
+
+#include <chrono>
+#include <iostream>
+
+AsyncMeshLoader::AsyncMeshLoader()
+    : finished_(false), ok_(false), hasBounds_(false), boundsMin_(0.0f), boundsMax_(0.0f),
+      buffers_(), cacheHit_(false), loadMs_(0.0) {}
+
+AsyncMeshLoader::~AsyncMeshLoader() {
+    if (thread_.joinable()) thread_.join();
+}
+
+void AsyncMeshLoader::start(const std::string& filename, const ObjLoadOptions& options, bool useCache, bool flat) {
+    if (thread_.joinable()) thread_.join();
+    finished_.store(false, std::memory_order_relaxed);
+    ok_ = false;
+    hasBounds_ = false;
+    ObjLoadOptions threadOptions = options;
+    threadOptions.onBounds = [this](const glm::vec3& lo, const glm::vec3& hi) { setBounds(lo, hi); };
+    thread_ = std::thread(&AsyncMeshLoader::run, this, filename, threadOptions, useCache, flat);
+}
+
+bool AsyncMeshLoader::bounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    std::lock_guard<std::mutex> lock(boundsMutex_);
+    if (!hasBounds_) return false;
+    boundsMin = boundsMin_;
+    boundsMax = boundsMax_;
+    return true;
+}
+
+void AsyncMeshLoader::setBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    std::lock_guard<std::mutex> lock(boundsMutex_);
+    boundsMin_ = boundsMin;
+    boundsMax_ = boundsMax;
+    hasBounds_ = true;
+}
+
+void AsyncMeshLoader::run(std::string filename, ObjLoadOptions options, bool useCache, bool flat) {
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = false;
+    if (flat) {
+        // 逐角点展开：只有顶点数组，按浮点布局直接绘制
+        int vertexCount = 0;
+        flatVertices_ = loadOBJ(filename, vertexCount, options);
+        ok = vertexCount > 0;
+        buffers_ = MeshBuffers();
+        buffers_.layout = VertexLayout::positionNormal();
+        buffers_.vertexData = flatVertices_.data();
+        buffers_.vertexBytes = flatVertices_.size() * sizeof(float);
+        buffers_.vertexCount = static_cast<uint32_t>(vertexCount);
+        buffers_.positionScale = glm::vec3(1.0f);
+        buffers_.positionOffset = glm::vec3(0.0f);
+    } else {
+        ok = loadOBJCached(filename, options, useCache, cache_, mesh_, packed_, buffers_, cacheHit_);
+        // 缓存命中时没有解析过程，包围盒取自缓存头
+        if (ok) setBounds(buffers_.boundsMin, buffers_.boundsMax);
+    }
+    loadMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    ok_ = ok;
+    finished_.store(true, std::memory_order_release);
+}
+
+void AsyncMeshLoader::release() {
+    if (thread_.joinable()) thread_.join();
+    cache_.close();
+    std::vector<float>().swap(mesh_.vertices);
+    std::vector<unsigned int>().swap(mesh_.indices);
+    std::vector<Meshlet>().swap(mesh_.meshlets);
+    std::vector<MeshLod>().swap(mesh_.lods);
+    std::vector<unsigned char>().swap(packed_.vertices);
+    std::vector<unsigned char>().swap(packed_.indices);
+    std::vector<float>().swap(flatVertices_);
+    buffers_ = MeshBuffers();
+}
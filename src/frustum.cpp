@@ -0,0 +1,149 @@
+#include "frustum.h"
+
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2 1
+#else
+#define FRUSTUM_SSE2 0
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // glm 为列主序：m[列][行]，取行向量组合
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum f;
+    f.planes[0] = row3 + row0; // 左
+    f.planes[1] = row3 - row0; // 右
+    f.planes[2] = row3 + row1; // 下
+    f.planes[3] = row3 - row1; // 上
+    f.planes[4] = row3 + row2; // 近
+    f.planes[5] = row3 - row2; // 远
+    for (int i = 0; i < 6; ++i) {
+        float len = glm::length(glm::vec3(f.planes[i]));
+        if (len > 0.0f) f.planes[i] /= len;
+    }
+    return f;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < 6; ++i) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+    }
+    return true;
+}
+
+void SphereArrays::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+}
+
+void BoxArrays::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    ex.resize(count);
+    ey.resize(count);
+    ez.resize(count);
+}
+
+void transformBox(const glm::vec3& center, const glm::vec3& extent, const glm::mat4* models, size_t count,
+                  BoxArrays& out) {
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const glm::mat4 &m = models[i];
+        glm::vec3 c = glm::vec3(m * glm::vec4(center, 1.0f));
+        glm::vec3 e = glm::abs(glm::vec3(m[0])) * extent.x + glm::abs(glm::vec3(m[1])) * extent.y +
+                      glm::abs(glm::vec3(m[2])) * extent.z;
+        out.x[i] = c.x;
+        out.y[i] = c.y;
+        out.z[i] = c.z;
+        out.ex[i] = e.x;
+        out.ey[i] = e.y;
+        out.ez[i] = e.z;
+    }
+}
+
+// 球：dot(n, c) + d < -r 时在某平面外侧；AABB：把 r 换成半长在法线上的投影 dot(|n|, e)
+unsigned Frustum::cullSpheres(const SphereArrays& s, uint8_t* visible) const {
+    const size_t n = s.size();
+    size_t i = 0;
+    unsigned count = 0;
+#if FRUSTUM_SSE2
+    for (; i + 4 <= n; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&s.x[i]), cy = _mm_loadu_ps(&s.y[i]), cz = _mm_loadu_ps(&s.z[i]);
+        const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&s.radius[i]));
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), cx),
+                                             _mm_mul_ps(_mm_set1_ps(planes[p].y), cy)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), cz), _mm_set1_ps(planes[p].w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negR));
+        }
+        const int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k) {
+            visible[i + k] = static_cast<uint8_t>(((mask >> k) & 1) ^ 1);
+            count += visible[i + k];
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        visible[i] = intersectsSphere(glm::vec3(s.x[i], s.y[i], s.z[i]), s.radius[i]) ? 1 : 0;
+        count += visible[i];
+    }
+    return count;
+}
+
+unsigned Frustum::cullBoxes(const BoxArrays& b, uint8_t* visible) const {
+    const size_t n = b.size();
+    size_t i = 0;
+    unsigned count = 0;
+#if FRUSTUM_SSE2
+    for (; i + 4 <= n; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&b.x[i]), cy = _mm_loadu_ps(&b.y[i]), cz = _mm_loadu_ps(&b.z[i]);
+        const __m128 ex = _mm_loadu_ps(&b.ex[i]), ey = _mm_loadu_ps(&b.ey[i]), ez = _mm_loadu_ps(&b.ez[i]);
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            const glm::vec4 &pl = planes[p];
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.x), cx), _mm_mul_ps(_mm_set1_ps(pl.y), cy)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pl.z), cz), _mm_set1_ps(pl.w)));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(pl.x)), ex),
+                                             _mm_mul_ps(_mm_set1_ps(std::fabs(pl.y)), ey)),
+                                  _mm_mul_ps(_mm_set1_ps(std::fabs(pl.z)), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        const int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k) {
+            visible[i + k] = static_cast<uint8_t>(((mask >> k) & 1) ^ 1);
+            count += visible[i + k];
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const glm::vec4 &pl = planes[p];
+            float d = pl.x * b.x[i] + pl.y * b.y[i] + pl.z * b.z[i] + pl.w;
+            float r = std::fabs(pl.x) * b.ex[i] + std::fabs(pl.y) * b.ey[i] + std::fabs(pl.z) * b.ez[i];
+            inside = d + r >= 0.0f;
+        }
+        visible[i] = inside ? 1 : 0;
+        count += visible[i];
+    }
+    return count;
+}
+
+void FrustumCullTotals::report(std::ostream& out) const {
+    if (!frames) return;
+    const float f = static_cast<float>(frames);
+    out << "Culling: objects " << objectsVisible / f << " visible / " << objectsCulled / f << " culled, chunks "
+        << chunksVisible / f << " visible / " << chunksCulled / f << " culled, " << ms / frames
+        << " ms per frame over " << frames << " frames" << std::endl;
+}
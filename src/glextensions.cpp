@@ -0,0 +1,73 @@
+#include "glextensions.h"
+
+#include <GLFW/glfw3.h>
+
+namespace {
+
+GLExtensions extensions = GLExtensions();
+
+template <typename T>
+void loadEntry(T& pointer, const char* name) {
+    if (!pointer) pointer = reinterpret_cast<T>(glfwGetProcAddress(name));
+}
+
+bool loadSeparateShaderObjects() {
+    if (!glfwExtensionSupported("GL_ARB_separate_shader_objects")) return false;
+    loadEntry(glad_glGenProgramPipelines, "glGenProgramPipelines");
+    loadEntry(glad_glDeleteProgramPipelines, "glDeleteProgramPipelines");
+    loadEntry(glad_glBindProgramPipeline, "glBindProgramPipeline");
+    loadEntry(glad_glUseProgramStages, "glUseProgramStages");
+    loadEntry(glad_glValidateProgramPipeline, "glValidateProgramPipeline");
+    loadEntry(glad_glGetProgramPipelineiv, "glGetProgramPipelineiv");
+    loadEntry(glad_glGetProgramPipelineInfoLog, "glGetProgramPipelineInfoLog");
+    loadEntry(glad_glProgramParameteri, "glProgramParameteri");
+    loadEntry(glad_glProgramUniform1i, "glProgramUniform1i");
+    loadEntry(glad_glProgramUniform1f, "glProgramUniform1f");
+    loadEntry(glad_glProgramUniform3fv, "glProgramUniform3fv");
+    loadEntry(glad_glProgramUniformMatrix3fv, "glProgramUniformMatrix3fv");
+    loadEntry(glad_glProgramUniformMatrix4fv, "glProgramUniformMatrix4fv");
+    return true;
+}
+
+} // namespace
+
+void loadGLExtensions() {
+    extensions = GLExtensions();
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile")) {
+        extensions.maxShaderCompilerThreads =
+            (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        extensions.parallelShaderCompile = true;
+    } else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile")) {
+        extensions.maxShaderCompilerThreads =
+            (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+        extensions.parallelShaderCompile = true;
+    }
+    // Core in 4.1, where glad has already loaded the entry points
+    if (GLAD_GL_VERSION_4_1 || loadSeparateShaderObjects()) {
+        extensions.separateShaderObjects =
+            glGenProgramPipelines && glDeleteProgramPipelines && glBindProgramPipeline && glUseProgramStages &&
+            glValidateProgramPipeline && glGetProgramPipelineiv && glGetProgramPipelineInfoLog &&
+            glProgramParameteri && glProgramUniform1i && glProgramUniform1f && glProgramUniform3fv &&
+            glProgramUniformMatrix3fv && glProgramUniformMatrix4fv;
+    }
+    if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) ||
+        glfwExtensionSupported("GL_ARB_buffer_storage")) {
+        extensions.bufferStorageEntry = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+        extensions.bufferStorage = extensions.bufferStorageEntry != NULL;
+    }
+    if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3)) {
+        loadEntry(extensions.dispatchCompute, "glDispatchCompute");
+        loadEntry(extensions.memoryBarrier, "glMemoryBarrier");
+        loadEntry(extensions.bindImageTexture, "glBindImageTexture");
+        loadEntry(extensions.multiDrawElementsIndirect, "glMultiDrawElementsIndirect");
+        extensions.computeCulling = extensions.dispatchCompute && extensions.memoryBarrier &&
+                                    extensions.bindImageTexture && extensions.multiDrawElementsIndirect;
+    }
+    const bool conservativeQueries = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3) ||
+                                     glfwExtensionSupported("GL_ARB_ES3_compatibility");
+    extensions.occlusionQueryTarget = conservativeQueries ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+}
+
+const GLExtensions& glExtensions() {
+    return extensions;
+}
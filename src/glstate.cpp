@@ -0,0 +1,229 @@
+#include "glstate.h"
+
+#include <iostream>
+
+namespace {
+
+const GLuint kUnknown = ~0u;
+
+const GLenum kBufferTargetEnums[] = {GL_ARRAY_BUFFER,     GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER,
+                                     GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,    GL_DRAW_INDIRECT_BUFFER};
+const GLenum kTextureTargetEnums[] = {GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D};
+const GLenum kCapabilityEnums[] = {GL_DEPTH_TEST,  GL_BLEND,           GL_CULL_FACE,
+                                   GL_SCISSOR_TEST, GL_RASTERIZER_DISCARD, GL_POLYGON_OFFSET_FILL};
+
+// Index of `value` in `table`, or -1 for targets the cache does not track
+template <size_t N>
+int indexOf(const GLenum (&table)[N], GLenum value) {
+    for (size_t i = 0; i < N; ++i) {
+        if (table[i] == value) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+}
+
+void GLStateStats::report(std::ostream& out, unsigned frames) const {
+    if (!frames) return;
+    out << "GL state: " << static_cast<float>(issued) / frames << " issued, " << static_cast<float>(filtered) / frames
+        << " filtered per frame over " << frames << " frames" << std::endl;
+}
+
+GLState::GLState() {
+    invalidate();
+    resetStats();
+}
+
+void GLState::invalidate() {
+    program_ = pipeline_ = vao_ = kUnknown;
+    for (int i = 0; i < kBufferTargets; ++i) buffers_[i] = kUnknown;
+    for (int i = 0; i < kUniformBindings; ++i) uniformRanges_[i].buffer = kUnknown;
+    activeUnit_ = kUnknown;
+    for (int u = 0; u < kTextureUnits; ++u) {
+        for (int t = 0; t < kTextureTargets; ++t) textures_[u][t] = kUnknown;
+    }
+    for (int i = 0; i < kCapabilities; ++i) capabilities_[i] = kUnknown;
+    depthMask_ = colorMask_ = kUnknown;
+    depthFunc_ = cullFace_ = kUnknown;
+    blend_[0] = blend_[1] = kUnknown;
+    scissor_[2] = viewport_[2] = -1;
+}
+
+bool GLState::changeRect(GLint (&cached)[4], GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (cached[0] == x && cached[1] == y && cached[2] == width && cached[3] == height) {
+        ++stats_.filtered;
+        return false;
+    }
+    cached[0] = x;
+    cached[1] = y;
+    cached[2] = width;
+    cached[3] = height;
+    ++stats_.issued;
+    return true;
+}
+
+void GLState::useProgram(GLuint program) {
+    if (change(program_, program)) glUseProgram(program);
+}
+
+void GLState::bindProgramPipeline(GLuint pipeline) {
+    if (change(pipeline_, pipeline)) glBindProgramPipeline(pipeline);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (!change(vao_, vao)) return;
+    glBindVertexArray(vao);
+    // Each vertex array carries its own element buffer binding
+    buffers_[indexOf(kBufferTargetEnums, GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int t = indexOf(kBufferTargetEnums, target);
+    if (t < 0) {
+        ++stats_.issued;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (change(buffers_[t], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    if (target == GL_UNIFORM_BUFFER && index < static_cast<GLuint>(kUniformBindings)) {
+        Range &r = uniformRanges_[index];
+        if (r.buffer == buffer && r.offset == offset && r.size == size) {
+            ++stats_.filtered;
+            return;
+        }
+        r.buffer = buffer;
+        r.offset = offset;
+        r.size = size;
+    }
+    ++stats_.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+    int t = indexOf(kBufferTargetEnums, target);
+    if (t >= 0) buffers_[t] = buffer;
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    if (target == GL_UNIFORM_BUFFER && index < static_cast<GLuint>(kUniformBindings)) {
+        Range &r = uniformRanges_[index];
+        if (r.buffer == buffer && r.offset == 0 && r.size == -1) {
+            ++stats_.filtered;
+            return;
+        }
+        r.buffer = buffer;
+        r.offset = 0;
+        r.size = -1;
+    }
+    ++stats_.issued;
+    glBindBufferBase(target, index, buffer);
+    int t = indexOf(kBufferTargetEnums, target);
+    if (t >= 0) buffers_[t] = buffer;
+}
+
+void GLState::activeTexture(GLenum unit) {
+    if (change(activeUnit_, unit)) glActiveTexture(unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    int t = indexOf(kTextureTargetEnums, target);
+    GLuint unit = activeUnit_ == kUnknown ? kUnknown : activeUnit_ - GL_TEXTURE0;
+    if (t < 0 || unit >= static_cast<GLuint>(kTextureUnits)) {
+        ++stats_.issued;
+        glBindTexture(target, texture);
+        return;
+    }
+    if (change(textures_[unit][t], texture)) glBindTexture(target, texture);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    int c = indexOf(kCapabilityEnums, capability);
+    if (c >= 0 && !change(capabilities_[c], static_cast<GLuint>(enabled))) return;
+    if (c < 0) ++stats_.issued;
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void GLState::depthMask(bool write) {
+    if (change(depthMask_, static_cast<GLuint>(write))) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::colorMask(bool write) {
+    if (!change(colorMask_, static_cast<GLuint>(write))) return;
+    GLboolean w = write ? GL_TRUE : GL_FALSE;
+    glColorMask(w, w, w, w);
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (change(depthFunc_, func)) glDepthFunc(func);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst) {
+    if (blend_[0] == src && blend_[1] == dst) {
+        ++stats_.filtered;
+        return;
+    }
+    blend_[0] = src;
+    blend_[1] = dst;
+    ++stats_.issued;
+    glBlendFunc(src, dst);
+}
+
+void GLState::cullFace(GLenum face) {
+    if (change(cullFace_, face)) glCullFace(face);
+}
+
+void GLState::scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (changeRect(scissor_, x, y, width, height)) glScissor(x, y, width, height);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (changeRect(viewport_, x, y, width, height)) glViewport(x, y, width, height);
+}
+
+void GLState::deleteProgram(GLuint program) {
+    if (!program) return;
+    glDeleteProgram(program);
+    // A current program is only flagged for deletion and stays in use, so program_ is kept
+}
+
+void GLState::deleteProgramPipeline(GLuint pipeline) {
+    if (!pipeline) return;
+    glDeleteProgramPipelines(1, &pipeline);
+    if (pipeline_ == pipeline) pipeline_ = 0;
+}
+
+void GLState::deleteVertexArray(GLuint vao) {
+    if (!vao) return;
+    glDeleteVertexArrays(1, &vao);
+    if (vao_ != vao) return;
+    // Deleting the bound vertex array reverts the binding to 0
+    vao_ = 0;
+    buffers_[indexOf(kBufferTargetEnums, GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+}
+
+void GLState::deleteBuffer(GLuint buffer) {
+    if (!buffer) return;
+    glDeleteBuffers(1, &buffer);
+    for (int i = 0; i < kBufferTargets; ++i) {
+        if (buffers_[i] == buffer) buffers_[i] = 0;
+    }
+    for (int i = 0; i < kUniformBindings; ++i) {
+        if (uniformRanges_[i].buffer == buffer) uniformRanges_[i].buffer = 0;
+    }
+}
+
+void GLState::deleteTexture(GLuint texture) {
+    if (!texture) return;
+    glDeleteTextures(1, &texture);
+    for (int u = 0; u < kTextureUnits; ++u) {
+        for (int t = 0; t < kTextureTargets; ++t) {
+            if (textures_[u][t] == texture) textures_[u][t] = 0;
+        }
+    }
+}
+
+GLState& glState() {
+    static GLState state;
+    return state;
+}
@@ -0,0 +1,239 @@
+#include "gpuculling.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "frustum.h"
+#include "glextensions.h"
+#include "glstate.h"
+#include "transform.h"
+
+namespace {
+
+// 计算着色器的资源绑定点（与 src/shader/gpucull.comp、hiz.comp 中的 layout(binding) 一致）
+const GLuint kInputBinding = 0;
+const GLuint kOutputBinding = 1;
+const GLuint kCommandBinding = 2;
+const GLuint kVisibilityBinding = 3;
+const GLuint kDepthUnit = 0;
+const GLuint kPyramidUnit = 1;
+const GLuint kCullGroupSize = 64;
+const GLuint kPyramidGroupSize = 8;
+
+GLuint groups(int size, GLuint groupSize) {
+    return (static_cast<GLuint>(size) + groupSize - 1) / groupSize;
+}
+
+bool compileCompute(Shader& shader, const std::string& path) {
+    shader.compileStage(GL_COMPUTE_SHADER, path, Shader::readFile(path));
+    return shader.finish();
+}
+
+}
+
+GpuCuller::GpuCuller()
+    : block_(), capacity_(0), mesh_(), commandsPerPhase_(0), vao_(0), commands_(0), visibility_(0), depth_(0),
+      pyramid_(0), width_(0), height_(0), levels_(0), calls_(0) {}
+
+GpuCuller::~GpuCuller() {
+    glState().deleteBuffer(commands_);
+    glState().deleteBuffer(visibility_);
+    glState().deleteTexture(depth_);
+    glState().deleteTexture(pyramid_);
+}
+
+bool GpuCuller::create(const std::string& shaderDir, size_t instanceCapacity) {
+    if (!glExtensions().computeCulling) return false;
+    if (!compileCompute(cullShader_, shaderDir + "gpucull.comp")) return false;
+    if (!compileCompute(hizShader_, shaderDir + "hiz.comp")) return false;
+    bindUniformBlocks(cullShader_);
+    phaseUniform_ = cullShader_.uniform<int>("uPhase");
+    levelUniform_ = hizShader_.uniform<int>("uLevel");
+    params_.create(kCullBlockBinding, sizeof(CullBlock));
+    capacity_ = instanceCapacity;
+
+    // 首帧没有上一帧的结果：全部视为可见，在阶段 0 绘制
+    std::vector<uint32_t> visible(capacity_, 1u);
+    glGenBuffers(1, &visibility_);
+    glState().bindBuffer(GL_COPY_WRITE_BUFFER, visibility_);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity_ * sizeof(uint32_t)), visible.data(),
+                 GL_DYNAMIC_COPY);
+    return true;
+}
+
+void GpuCuller::setMesh(const GpuCullMesh& mesh) {
+    mesh_ = mesh;
+    const bool selectLods = mesh.lods && mesh.lodCount > 1 && mesh.lodThreshold > 0.0f;
+    commandsPerPhase_ = selectLods ? std::min(mesh.lodCount, kMaxLods) : 1;
+
+    // 每个 (阶段, LOD) 一条命令，各占输出中 capacity_ 个实例的区域，baseInstance 指向区域起点
+    for (int p = 0; p < kPhases; ++p) {
+        for (unsigned l = 0; l < commandsPerPhase_; ++l) {
+            unsigned region = p * commandsPerPhase_ + l;
+            DrawElementsIndirectCommand &c = templates_[region];
+            c.count = mesh.lods ? mesh.lods[l].indexCount : mesh.indexCount;
+            c.instanceCount = 0;
+            c.firstIndex = mesh.lods ? mesh.lods[l].indexOffset : 0;
+            c.baseVertex = 0;
+            c.baseInstance = static_cast<uint32_t>(region * capacity_);
+        }
+    }
+    glGenBuffers(1, &commands_);
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(kPhases * commandsPerPhase_ * sizeof(templates_[0]));
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, templates_, GL_DYNAMIC_DRAW);
+
+    output_.create(kPhases * commandsPerPhase_ * capacity_);
+    output_.attach(mesh.vao);
+    glState().bindVertexArray(0);
+    glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    block_.boundsCenter = glm::vec4(mesh.boundsCenter, mesh.boundsRadius);
+    block_.boundsExtent = glm::vec4(mesh.boundsExtent, 0.0f);
+    if (mesh.lods) {
+        for (unsigned l = 0; l < commandsPerPhase_; ++l) block_.lodError[l / 4][l % 4] = mesh.lods[l].error;
+    }
+    block_.lodThreshold = mesh.lodThreshold;
+    block_.lodCount = commandsPerPhase_;
+    vao_ = mesh.vao;
+}
+
+void GpuCuller::resizePyramid(int width, int height) {
+    width_ = width;
+    height_ = height;
+    levels_ = 1;
+    while ((std::max(width, height) >> levels_) > 0) ++levels_;
+
+    if (!depth_) glGenTextures(1, &depth_);
+    glState().activeTexture(GL_TEXTURE0 + kDepthUnit);
+    glState().bindTexture(GL_TEXTURE_2D, depth_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // texelFetch 也要求纹理完整：分配全部级别并限定最高级
+    if (!pyramid_) glGenTextures(1, &pyramid_);
+    glState().activeTexture(GL_TEXTURE0 + kPyramidUnit);
+    glState().bindTexture(GL_TEXTURE_2D, pyramid_);
+    for (int level = 0; level < levels_; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(width >> level, 1), std::max(height >> level, 1), 0,
+                     GL_RED, GL_FLOAT, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels_ - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void GpuCuller::beginFrame(const glm::mat4& viewProj, const glm::mat4& objectModel, const glm::vec3& camera,
+                           float pixelScale, const InstanceBuffer& input, size_t instanceCount, int width,
+                           int height) {
+    calls_ = 0;
+    if (width != width_ || height != height_) resizePyramid(width, height);
+
+    Frustum frustum = Frustum::fromMatrix(viewProj);
+    block_.viewProj = viewProj;
+    block_.objectModel = objectModel;
+    const glm::mat3 normal = normalMatrix(objectModel);
+    for (int c = 0; c < 3; ++c) block_.objectNormal[c] = glm::vec4(normal[c], 0.0f);
+    for (int i = 0; i < 6; ++i) block_.planes[i] = frustum.planes[i];
+    block_.camera = glm::vec4(camera, pixelScale);
+    block_.viewport = glm::vec2(static_cast<float>(width), static_cast<float>(height));
+    block_.instanceCount = static_cast<uint32_t>(std::min(instanceCount, capacity_));
+    block_.inputBase = static_cast<uint32_t>(input.base() / sizeof(uint32_t));
+    block_.inputCapacity = static_cast<uint32_t>(input.capacity());
+    block_.hizLevels = static_cast<uint32_t>(levels_);
+    params_.update(0, block_);
+    params_.bind();
+    calls_ += 2;
+
+    // 重置各命令的实例计数
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(kPhases * commandsPerPhase_ * sizeof(templates_[0]));
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, templates_);
+    calls_ += 2;
+
+    // 输入按整个缓冲绑定（数据所在的环形缓冲区域每帧不同，偏移经 inputBase 传入）
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, kInputBinding, input.source());
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, kOutputBinding, output_.storage());
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding, commands_);
+    glState().bindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibilityBinding, visibility_);
+    calls_ += 4;
+}
+
+void GpuCuller::cull(int phase) {
+    const GLExtensions &ext = glExtensions();
+    cullShader_.use();
+    cullShader_.set(phaseUniform_, phase);
+    calls_ += 2;
+    if (phase > 0) {
+        glState().activeTexture(GL_TEXTURE0 + kPyramidUnit);
+        glState().bindTexture(GL_TEXTURE_2D, pyramid_);
+        calls_ += 2;
+    }
+    ext.dispatchCompute(groups(static_cast<int>(block_.instanceCount), kCullGroupSize), 1, 1);
+    // 命令与实例数据随后作为间接绘制参数和顶点属性读取；可见标记由下一次剔除读取
+    ext.memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    calls_ += 2;
+    // 间接绘制从 GL_DRAW_INDIRECT_BUFFER 读取命令
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    ++calls_;
+}
+
+void GpuCuller::buildDepthPyramid() {
+    const GLExtensions &ext = glExtensions();
+    glState().activeTexture(GL_TEXTURE0 + kDepthUnit);
+    glState().bindTexture(GL_TEXTURE_2D, depth_);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width_, height_);
+    hizShader_.use();
+    calls_ += 4;
+    // 级别 0 复制深度，之后每级由上一级取最远深度；级间以屏障保证上一级已写完
+    for (int level = 0; level < levels_; ++level) {
+        ext.bindImageTexture(0, pyramid_, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        ext.bindImageTexture(1, pyramid_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        hizShader_.set(levelUniform_, level);
+        ext.dispatchCompute(groups(std::max(width_ >> level, 1), kPyramidGroupSize),
+                            groups(std::max(height_ >> level, 1), kPyramidGroupSize), 1);
+        ext.memoryBarrier(level + 1 < levels_ ? GL_SHADER_IMAGE_ACCESS_BARRIER_BIT : GL_TEXTURE_FETCH_BARRIER_BIT);
+        calls_ += 5;
+    }
+}
+
+DrawCommand GpuCuller::draw(int phase) const {
+    uintptr_t offset = static_cast<uintptr_t>(phase) * commandsPerPhase_ * sizeof(DrawElementsIndirectCommand);
+    return indirectDraw(GL_TRIANGLES, mesh_.indexType, offset, static_cast<GLsizei>(commandsPerPhase_));
+}
+
+void GpuCuller::submit(RenderQueue& queue, Shader* shader) const {
+    for (int phase = 0; phase < kPhases; ++phase) {
+        RenderItem item = RenderItem();
+        item.shader = shader;
+        item.vao = vao_;
+        item.draw = draw(phase);
+        item.key = makeSortKey(phase == 0 ? RENDER_PASS_OPAQUE : RENDER_PASS_OPAQUE_LATE, queue.programIndex(shader),
+                               0, vao_, 0.0f);
+        queue.submit(item);
+    }
+}
+
+void GpuCuller::readVisibleCounts(unsigned& early, unsigned& late) const {
+    early = late = 0;
+    if (!commands_) return;
+    DrawElementsIndirectCommand commands[kPhases * kMaxLods];
+    glExtensions().memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(kPhases * commandsPerPhase_ * sizeof(commands[0]));
+    glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, commands);
+    for (unsigned l = 0; l < commandsPerPhase_; ++l) {
+        early += commands[l].instanceCount;
+        late += commands[commandsPerPhase_ + l].instanceCount;
+    }
+}
+
+void GpuCuller::report(std::ostream& out, size_t instanceCount) const {
+    unsigned early = 0, late = 0;
+    readVisibleCounts(early, late);
+    out << "GPU culling: " << early + late << " of " << instanceCount << " instances drawn (" << early
+        << " visible last frame, " << late << " newly visible), " << calls_ << " GL calls per frame for culling"
+        << std::endl;
+}
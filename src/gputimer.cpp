@@ -0,0 +1,49 @@
+#include "gputimer.h"
+
+#include <iostream>
+
+GpuTimer::GpuTimer() : next_(0), active_(false), totalMs_(0.0), samples_(0) {
+    glGenQueries(kQueries, queries_);
+    for (int i = 0; i < kQueries; ++i) pending_[i] = false;
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(kQueries, queries_);
+}
+
+void GpuTimer::begin() {
+    // 所有查询都未完成时跳过本次计时，而不是等待
+    if (pending_[next_]) collect();
+    if (pending_[next_]) return;
+    glBeginQuery(GL_TIME_ELAPSED, queries_[next_]);
+    active_ = true;
+}
+
+void GpuTimer::end() {
+    if (!active_) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_[next_] = true;
+    next_ = (next_ + 1) % kQueries;
+    active_ = false;
+}
+
+void GpuTimer::collect() {
+    // 按发出顺序收取，遇到未完成的即停止
+    for (int n = 0; n < kQueries; ++n) {
+        int i = (next_ + n) % kQueries;
+        if (!pending_[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries_[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries_[i], GL_QUERY_RESULT, &ns);
+        totalMs_ += static_cast<double>(ns) * 1e-6;
+        ++samples_;
+        pending_[i] = false;
+    }
+}
+
+void GpuTimer::report(std::ostream& out, const char* label) const {
+    if (!samples_) return;
+    out << "GPU: " << label << " " << averageMs() << " ms per frame over " << samples_ << " frames" << std::endl;
+}
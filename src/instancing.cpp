@@ -0,0 +1,109 @@
+#include "instancing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "glstate.h"
+#include "ringbuffer.h"
+#include "transform.h"
+
+void InstanceArrays::resize(size_t count) {
+    model.resize(count);
+    normal.resize(count);
+    material.resize(count);
+}
+
+void layoutInstanceGrid(InstanceArrays& instances, int gridSize, float spacing, const glm::mat4& model,
+                        unsigned materialCount, const glm::vec3& rowAxis) {
+    instances.resize(static_cast<size_t>(gridSize) * gridSize);
+    const float origin = -0.5f * spacing * (gridSize - 1);
+    size_t i = 0;
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x, ++i) {
+            glm::vec3 offset = glm::vec3(origin + spacing * x, 0.0f, 0.0f) + (origin + spacing * y) * rowAxis;
+            instances.model[i] = glm::translate(glm::mat4(1.0f), offset) * model;
+            instances.material[i] = static_cast<uint32_t>((x + y) % materialCount);
+        }
+    }
+    for (i = 0; i < instances.size(); ++i) instances.normal[i] = normalMatrix(instances.model[i]);
+}
+
+InstanceBuffer::~InstanceBuffer() {
+    glState().deleteBuffer(buffer_);
+}
+
+void InstanceBuffer::create(size_t capacity) {
+    capacity_ = capacity;
+    if (!buffer_) glGenBuffers(1, &buffer_);
+    glState().bindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes()), NULL, GL_STREAM_DRAW);
+    source_ = buffer_;
+    base_ = 0;
+}
+
+void InstanceBuffer::attach(GLuint vao) {
+    vaos_.push_back(vao);
+    glState().bindVertexArray(vao);
+    setPointers();
+}
+
+void InstanceBuffer::setSource(GLuint buffer, size_t base) {
+    if (buffer == source_ && base == base_) return;
+    source_ = buffer;
+    base_ = base;
+    for (size_t i = 0; i < vaos_.size(); ++i) {
+        glState().bindVertexArray(vaos_[i]);
+        setPointers();
+    }
+}
+
+void InstanceBuffer::setPointers() const {
+    glState().bindBuffer(GL_ARRAY_BUFFER, source_);
+    for (GLuint c = 0; c < 4; ++c) {
+        GLuint location = kInstanceModelLocation + c;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(uintptr_t)(base_ + c * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    for (GLuint c = 0; c < 3; ++c) {
+        GLuint location = kInstanceNormalLocation + c;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(glm::mat3),
+                              (void*)(uintptr_t)(base_ + normalOffset() + c * sizeof(glm::vec3)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    glVertexAttribIPointer(kInstanceMaterialLocation, 1, GL_UNSIGNED_INT, sizeof(uint32_t),
+                           (void*)(uintptr_t)(base_ + materialOffset()));
+    glVertexAttribDivisor(kInstanceMaterialLocation, 1);
+    glEnableVertexAttribArray(kInstanceMaterialLocation);
+}
+
+void InstanceBuffer::update(const InstanceArrays& instances, DynamicRingBuffer* ring) {
+    size_t count = std::min(instances.size(), capacity_);
+    RingAllocation a = ring ? ring->allocate(bytes(), 16) : RingAllocation();
+    if (a.data) {
+        // 持久映射：直接写入本帧区域，GPU 读完前该区域不会被复写（见 DynamicRingBuffer）
+        unsigned char *dst = static_cast<unsigned char*>(a.data);
+        memcpy(dst, instances.model.data(), count * sizeof(glm::mat4));
+        memcpy(dst + normalOffset(), instances.normal.data(), count * sizeof(glm::mat3));
+        memcpy(dst + materialOffset(), instances.material.data(), count * sizeof(uint32_t));
+        setSource(a.buffer, a.offset);
+        return;
+    }
+    setSource(buffer_, 0);
+    glState().bindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes()), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), instances.model.data());
+    glBufferSubData(GL_ARRAY_BUFFER, normalOffset(), count * sizeof(glm::mat3), instances.normal.data());
+    glBufferSubData(GL_ARRAY_BUFFER, materialOffset(), count * sizeof(uint32_t), instances.material.data());
+}
+
+void InstanceTotals::report(std::ostream& out, size_t instances, long long triangles) const {
+    if (!frames) return;
+    out << "Instances: " << instances << " (" << triangles << " triangles), CPU frame " << frameMs / frames
+        << " ms, instance update " << updateMs / frames << " ms per frame over " << frames << " frames" << std::endl;
+}
@@ -1,154 +1,220 @@
 #include "loadobj.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <cstdio>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 
-std::vector<float> loadOBJ(const std::string& filename, int& vertexCount)
-{
-    // 输出交错数据: pos(3) + normal(3)
-    std::vector<float> vertices;
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> normals;
-    struct Idx { int v; int n; };
-    std::vector<std::vector<Idx>> faces;
+#include "meshopt.h"
+#include "objparser.h"
+#include "simplify.h"
+#include "threadpool.h"
 
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+namespace {
+
+// 解析后的 OBJ 与逐顶点法线来源
+struct LoadedOBJ {
+    ObjData obj;
+    std::vector<glm::vec3> smoothNormals; // 未提供 vn 时按位置索引的平滑法线
+    bool hasProvidedNormals;
+    size_t bytes;
+    double parseMs;
+};
+
+bool parseTimed(const std::string& filename, const ObjLoadOptions& options, LoadedOBJ& out)
+{
+    // 内存映射 + 指针式分词解析
+    out.bytes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!parseOBJFile(filename, out.obj, out.bytes, options.threads)) {
         std::cout << "ERROR: Cannot open OBJ file: " << filename << std::endl;
-        return vertices;
+        return false;
     }
+    out.parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    out.hasProvidedNormals = !out.obj.normals.empty();
+    return true;
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
-
-        if (prefix == "v") {
-            // 读取顶点坐标
-            float x, y, z;
-            iss >> x >> y >> z;
-            positions.emplace_back(x, y, z);
-        }
-        else if (prefix == "vn") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            normals.emplace_back(x, y, z);
-        }
-        else if (prefix == "f") {
-            // 读取面（支持三角/四边形）
-            std::string token;
-            std::vector<Idx> face;
-            while (iss >> token) {
-                int v = 0, t = 0, n = 0;
-                // 解析 v//n 或 v/t/n 或 v
-                if (sscanf(token.c_str(), "%d/%d/%d", &v, &t, &n) == 3) {
-                    // v/t/n
-                } else if (sscanf(token.c_str(), "%d//%d", &v, &n) == 2) {
-                    // v//n
-                } else if (sscanf(token.c_str(), "%d/%d", &v, &t) == 2) {
-                    // v/t 但无法线
-                } else if (sscanf(token.c_str(), "%d", &v) == 1) {
-                    // 仅 v
-                }
-                face.push_back({v - 1, n - 1}); // 转为 0 基
-            }
-            // 三角或四边形
-            if (face.size() == 3) {
-                faces.push_back(face);
-            } else if (face.size() == 4) {
-                // 拆分为两个三角形: 0-1-2, 0-2-3
-                faces.push_back({face[0], face[1], face[2]});
-                faces.push_back({face[0], face[2], face[3]});
-            }
+bool loadAndPrepare(const std::string& filename, const ObjLoadOptions& options, LoadedOBJ& out)
+{
+    if (!parseTimed(filename, options, out)) return false;
+    if (options.onBounds && !out.obj.positions.empty()) {
+        glm::vec3 lo = out.obj.positions[0], hi = lo;
+        for (size_t i = 1; i < out.obj.positions.size(); ++i) {
+            lo = glm::min(lo, out.obj.positions[i]);
+            hi = glm::max(hi, out.obj.positions[i]);
         }
+        options.onBounds(lo, hi);
+    }
+    // 若 OBJ 未提供法线，则生成平滑顶点法线（默认角度加权，推荐用于 Phong Shading）
+    if (!out.hasProvidedNormals) {
+        auto t0 = std::chrono::steady_clock::now();
+        out.smoothNormals = computeVertexNormals(out.obj.positions, out.obj.corners,
+                                                 options.normalWeighting, options.threads);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "Normals: " << normalWeightingName(options.normalWeighting) << "-weighted in "
+                  << ms << " ms" << std::endl;
     }
+    return true;
+}
 
-    file.close();
-    // 根据索引构建最终的顶点数组（交错: pos + normal）
-    // 若 OBJ 未提供法线，则使用“角度加权”平均的平滑顶点法线（推荐用于 Phong Shading）
-    bool hasProvidedNormals = !normals.empty();
-    std::vector<glm::vec3> smoothNormals;
-    if (!hasProvidedNormals) {
-        smoothNormals.assign(positions.size(), glm::vec3(0.0f));
-        auto safeNormalize = [](const glm::vec3 &v) -> glm::vec3 {
-            float len = glm::length(v);
-            return (len > 1e-8f) ? (v / len) : glm::vec3(0.0f);
-        };
-        auto clampDot = [](float d) { return glm::clamp(d, -1.0f, 1.0f); };
-
-        for (const auto &tri : faces) {
-            if (tri.size() != 3) continue;
-            int i0 = tri[0].v, i1 = tri[1].v, i2 = tri[2].v;
-            if (i0 < 0 || i1 < 0 || i2 < 0) continue;
-            glm::vec3 p0 = positions[i0];
-            glm::vec3 p1 = positions[i1];
-            glm::vec3 p2 = positions[i2];
-            glm::vec3 e0 = p1 - p0;
-            glm::vec3 e1 = p2 - p0;
-            glm::vec3 e2 = p2 - p1;
-
-            glm::vec3 fn = glm::cross(e0, e1);
-            float area2 = glm::length(fn);
-            if (area2 < 1e-12f) continue; // 退化三角形
-            fn /= area2; // 先单位化（方向）
-
-            // 角度加权（可选与面积加权结合，这里角度权重已隐含形状特征）
-            glm::vec3 u0 = glm::normalize(e0);
-            glm::vec3 v0 = glm::normalize(e1);
-            glm::vec3 u1 = glm::normalize(p0 - p1);
-            glm::vec3 v1 = glm::normalize(p2 - p1);
-            glm::vec3 u2 = glm::normalize(p0 - p2);
-            glm::vec3 v2 = glm::normalize(p1 - p2);
-
-            float a0 = acosf(glm::clamp(glm::dot(u0, v0), -1.0f, 1.0f));
-            float a1 = acosf(glm::clamp(glm::dot(u1, v1), -1.0f, 1.0f));
-            float a2 = acosf(glm::clamp(glm::dot(u2, v2), -1.0f, 1.0f));
-
-            // 累加角度加权的面法线
-            smoothNormals[i0] += fn * a0;
-            smoothNormals[i1] += fn * a1;
-            smoothNormals[i2] += fn * a2;
-        }
-        // 归一化
-        for (auto &n : smoothNormals) {
-            float len = glm::length(n);
-            if (len > 1e-8f) n /= len;
-        }
+// 三角形三个角点均引用有效位置
+inline bool validTriangle(const ObjIndex *tri, int positionCount)
+{
+    for (int i = 0; i < 3; ++i) {
+        if (tri[i].v < 0 || tri[i].v >= positionCount) return false;
     }
+    return true;
+}
+
+// 角点使用的法线：提供的 vn 无效时回退为 -1
+inline int providedNormalIndex(const LoadedOBJ& in, const ObjIndex& idx)
+{
+    return (idx.n >= 0 && idx.n < (int)in.obj.normals.size()) ? idx.n : -1;
+}
 
-    for (const auto &tri : faces) {
-        // 输出三角形顶点
-        if (tri.size() != 3) continue;
+void appendVertex(std::vector<float>& vertices, const LoadedOBJ& in, const ObjIndex& idx)
+{
+    glm::vec3 pos = in.obj.positions[idx.v];
+    glm::vec3 nrm;
+    if (in.hasProvidedNormals && providedNormalIndex(in, idx) >= 0) {
+        nrm = in.obj.normals[idx.n];
+    } else if (!in.hasProvidedNormals) {
+        nrm = in.smoothNormals[idx.v];
+    } else {
+        // 极端退化回退：使用(0,0,1)
+        nrm = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    vertices.push_back(pos.x);
+    vertices.push_back(pos.y);
+    vertices.push_back(pos.z);
+    vertices.push_back(nrm.x);
+    vertices.push_back(nrm.y);
+    vertices.push_back(nrm.z);
+}
+
+void printStats(const std::string& filename, const LoadedOBJ& in, const ObjLoadOptions& options, int triangles)
+{
+    std::cout << "Loaded OBJ file: " << filename << std::endl;
+    std::cout << "Positions: " << in.obj.positions.size() << ", Normals: " << in.obj.normals.size() << std::endl;
+    std::cout << "Triangles: " << triangles << std::endl;
+    double mb = in.bytes / (1024.0 * 1024.0);
+    unsigned threads = options.threads ? options.threads : ThreadPool::shared().size();
+    std::cout << "Parse: " << mb << " MB in " << in.parseMs << " ms ("
+              << (in.parseMs > 0.0 ? mb / (in.parseMs / 1000.0) : 0.0) << " MB/s, "
+              << threads << " threads)" << std::endl;
+}
+
+} // namespace
+
+std::vector<float> loadOBJ(const std::string& filename, int& vertexCount)
+{
+    return loadOBJ(filename, vertexCount, ObjLoadOptions());
+}
+
+std::vector<float> loadOBJ(const std::string& filename, int& vertexCount, const ObjLoadOptions& options)
+{
+    // 输出交错数据: pos(3) + normal(3)
+    std::vector<float> vertices;
+    vertexCount = 0;
+
+    LoadedOBJ in;
+    if (!loadAndPrepare(filename, options, in)) return vertices;
+
+    // 根据索引构建最终的顶点数组（交错: pos + normal），每个角点一个顶点
+    const std::vector<ObjIndex> &corners = in.obj.corners;
+    const int positionCount = static_cast<int>(in.obj.positions.size());
+    vertices.reserve(corners.size() * 6);
+    for (size_t c = 0; c + 2 < corners.size(); c += 3) {
+        // 跳过引用越界位置的三角形
+        if (!validTriangle(&corners[c], positionCount)) continue;
+        for (int i = 0; i < 3; ++i) appendVertex(vertices, in, corners[c + i]);
+    }
+
+    vertexCount = vertices.size() / 6; // 每个顶点 6 个 float
+    printStats(filename, in, options, vertexCount / 3);
+    return vertices;
+}
+
+bool loadOBJMesh(const std::string& filename, Mesh& mesh, const ObjLoadOptions& options)
+{
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.meshlets.clear();
+    mesh.lods.clear();
+
+    LoadedOBJ in;
+    if (!loadAndPrepare(filename, options, in)) return false;
+
+    // 顶点去重：平滑法线只取决于位置索引，直接按位置建表；
+    // 提供 vn 时按 (位置, 法线) 组合去重
+    const std::vector<ObjIndex> &corners = in.obj.corners;
+    const int positionCount = static_cast<int>(in.obj.positions.size());
+    std::vector<int> byPosition;
+    std::unordered_map<uint64_t, unsigned int> byPair;
+    if (in.hasProvidedNormals) byPair.reserve(in.obj.positions.size());
+    else byPosition.assign(in.obj.positions.size(), -1);
+
+    mesh.vertices.reserve(in.obj.positions.size() * 6);
+    mesh.indices.reserve(corners.size());
+    for (size_t c = 0; c + 2 < corners.size(); c += 3) {
+        if (!validTriangle(&corners[c], positionCount)) continue;
         for (int i = 0; i < 3; ++i) {
-            const auto &idx = tri[i];
-            glm::vec3 pos = positions[idx.v];
-            glm::vec3 nrm;
-            if (hasProvidedNormals && idx.n >= 0 && idx.n < (int)normals.size()) {
-                nrm = normals[idx.n];
-            } else if (!hasProvidedNormals && idx.v >= 0 && idx.v < (int)smoothNormals.size()) {
-                nrm = smoothNormals[idx.v];
+            const ObjIndex &idx = corners[c + i];
+            unsigned int next = static_cast<unsigned int>(mesh.vertexCount());
+            unsigned int vi;
+            if (in.hasProvidedNormals) {
+                uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(idx.v)) << 32) |
+                               static_cast<uint32_t>(providedNormalIndex(in, idx));
+                auto res = byPair.insert(std::make_pair(key, next));
+                vi = res.first->second;
+                if (res.second) appendVertex(mesh.vertices, in, idx);
             } else {
-                // 极端退化回退：使用(0,0,1)
-                nrm = glm::vec3(0.0f, 0.0f, 1.0f);
+                int &slot = byPosition[idx.v];
+                if (slot < 0) {
+                    slot = static_cast<int>(next);
+                    appendVertex(mesh.vertices, in, idx);
+                }
+                vi = static_cast<unsigned int>(slot);
             }
-            vertices.push_back(pos.x);
-            vertices.push_back(pos.y);
-            vertices.push_back(pos.z);
-            vertices.push_back(nrm.x);
-            vertices.push_back(nrm.y);
-            vertices.push_back(nrm.z);
+            mesh.indices.push_back(vi);
         }
     }
 
-    vertexCount = vertices.size() / 6; // 每个顶点 6 个 float
-    std::cout << "Loaded OBJ file: " << filename << std::endl;
-    std::cout << "Positions: " << positions.size() << ", Normals: " << normals.size() << std::endl;
-    std::cout << "Triangles: " << (vertexCount / 3) << std::endl;
+    printStats(filename, in, options, mesh.indexCount() / 3);
+    std::cout << "Vertices: " << mesh.vertexCount() << " (deduplicated from " << mesh.indexCount()
+              << " corners), index size: " << mesh.indexSize() * 8 << "-bit" << std::endl;
+    if (options.optimize) optimizeMesh(mesh);
 
-    return vertices;
+    // 网格簇用于渲染时的视锥 / 背面剔除
+    auto t0 = std::chrono::steady_clock::now();
+    mesh.meshlets = buildMeshlets(mesh);
+    size_t withCone = 0;
+    for (size_t i = 0; i < mesh.meshlets.size(); ++i) {
+        if (mesh.meshlets[i].coneCutoff < 1.0f) ++withCone;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Meshlets: " << mesh.meshlets.size() << " (" << withCone << " with normal cones), built in "
+              << ms << " ms" << std::endl;
+
+    if (options.lods) {
+        t0 = std::chrono::steady_clock::now();
+        buildLodChain(mesh, kLodRatios, kLodRatioCount);
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        glm::vec3 lo, hi;
+        mesh.computeBounds(lo, hi);
+        glm::vec3 extent = hi - lo;
+        float size = std::max(extent.x, std::max(extent.y, extent.z));
+        std::cout << "LOD chain: " << mesh.lods.size() << " levels in " << ms << " ms" << std::endl;
+        for (size_t i = 0; i < mesh.lods.size(); ++i) {
+            const MeshLod &lod = mesh.lods[i];
+            std::cout << "  LOD " << i << ": " << lod.indexCount / 3 << " triangles ("
+                      << 100.0 * lod.indexCount / mesh.lods[0].indexCount << "%), error " << lod.error
+                      << " (" << (size > 0.0f ? lod.error / size : 0.0f) << " of bounds)" << std::endl;
+        }
+    }
+    return true;
 }
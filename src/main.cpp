@@ -5,23 +5,152 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <cmath>
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <string>
+#include <thread>
 
 #include "shader.h"
+#include "shadermanager.h"
+#include "glextensions.h"
+#include "glstate.h"
+#include "gpuculling.h"
+#include "gputimer.h"
+#include "instancing.h"
+#include "renderqueue.h"
+#include "ringbuffer.h"
+#include "asyncloader.h"
 #include "loadobj.h"
+#include "meshdraws.h"
+#include "objectculling.h"
+#include "occlusionquery.h"
+#include "meshcache.h"
+#include "transform.h"
+#include "uniformblocks.h"
+#include "upload.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 
+// 逐物体 uniform 句柄，切换程序时重新查找；程序不含的 uniform 为无效句柄
+struct ObjectUniforms {
+    Uniform<glm::mat4> mvp;
+    Uniform<glm::mat4> model;
+    Uniform<glm::mat3> normalMatrix;
+    Uniform<glm::vec3> posScale;
+    Uniform<glm::vec3> posOffset;
+    Uniform<int> normalEncoding;
+};
+ObjectUniforms lookupObjectUniforms(const Shader& shader);
+// CPU 剔除路径逐物体提交的输入：第 i 个物体的变换、剔除结果、绘制命令与材质下标
+struct ObjectBatch {
+    const ObjectTransform* transforms;
+    size_t count;
+    const uint8_t* visible;    // 为 NULL 时都已通过剔除
+    const DrawCommand* draws;  // 为 NULL 时都用 draw
+    DrawCommand draw;
+    const uint32_t* materials; // 为 NULL 时都用材质 0
+    GLuint vao;
+};
+void submitObjects(RenderQueue& queue, const ObjectBatch& batch, const std::vector<Shader*>& materialShaders,
+                   OcclusionQueries* queries, const glm::vec3& boundsCenter, const glm::vec3& camera, float farPlane);
+MaterialBlock materialPreset(char id, ShadingModel model);
+void setupVertexLayout(const VertexLayout& layout);
+std::vector<float> boundingBoxLines(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+void printUsage(const char* program);
+bool parseArg(const char* name, const char* text, float& value);
+bool parseArg(const char* name, const char* text, double& value);
+bool parseArg(const char* name, const char* text, int& value);
+
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
 int main(int argc, char** argv) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    // 以 "--" 开头的为选项，从 argv 中剔除后其余仍按位置参数处理
+    bool flatMesh = false; // --flat: 使用旧的逐角点展开顶点 + glDrawArrays
+    bool useMeshCache = true; // --no-cache: 总是解析 OBJ，不读写二进制缓存
+    bool meshletCulling = true; // --no-meshlets: 整网格一次绘制，不做逐簇剔除
+    float lodThreshold = 0.0f; // --lod-threshold <px>: LOD 允许的最大屏幕空间误差（像素），0 = 总用完整网格
+    bool fastFresnel = false; // --fast-fresnel: Cook-Torrance 使用近似 Schlick 菲涅尔（非精确）
+    bool separableShaders = true; // --no-separable: 每个程序独立链接，不共享相同的着色器阶段
+    bool gpuTiming = false; // --gpu-timing: 每秒输出模型绘制与仅顶点阶段的 GPU 耗时
+    bool shaderTransforms = false; // --shader-transforms: 法线矩阵在顶点着色器中逐顶点求逆（与 CPU 预计算对比）
+    int gridSize = 0; // --grid <N>: 以实例化绘制 N×N 个模型副本，0 = 单个模型的普通绘制
+    bool instancing = true; // --no-instancing: --grid 的每个副本作为独立物体各自绘制（混合材质场景）
+    bool persistentRing = true; // --no-persistent: 每帧动态数据不经持久映射的环形缓冲，回退到 glBufferSubData
+    bool gridDepth = false; // --grid-depth: --grid 的行沿视线方向前后排开（密集遮挡场景），默认在 XY 平面
+    bool occlusionCulling = false; // --occlusion: 多个物体时以 CPU 软件光栅化的深度缓冲做遮挡剔除
+    bool occlusionQueries = false; // --occlusion-queries: 独立物体以硬件遮挡查询 + 条件渲染跳过被遮挡者
+    bool gpuCulling = false; // --gpu-culling: 实例化时由计算着色器剔除实例并生成间接绘制命令（GL 4.3）
+    double uploadBudgetMs = 4.0; // --upload-budget <ms>: 加载期间每帧用于上传网格数据的时间上限
+    ObjLoadOptions loadOptions;
+    bool argsValid = true; // 数值参数无法解析时输出用法并退出
+    int positional = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--flat") flatMesh = true;
+        else if (arg == "--no-cache") useMeshCache = false;
+        else if (arg == "--fast-fresnel") fastFresnel = true;
+        else if (arg == "--no-separable") separableShaders = false;
+        else if (arg == "--gpu-timing") gpuTiming = true;
+        else if (arg == "--shader-transforms") shaderTransforms = true;
+        else if (arg == "--no-shader-cache") Shader::setBinaryCacheEnabled(false); // 总是从源码编译着色器
+        else if (arg == "--no-optimize") loadOptions.optimize = false; // 保持 OBJ 原始三角形顺序
+        else if (arg == "--no-meshlets") meshletCulling = false;
+        else if (arg == "--no-lod") loadOptions.lods = false;
+        else if (arg == "--lod-threshold" && i + 1 < argc) {
+            argsValid &= parseArg("--lod-threshold", argv[++i], lodThreshold);
+        }
+        else if (arg == "--upload-budget" && i + 1 < argc) {
+            argsValid &= parseArg("--upload-budget", argv[++i], uploadBudgetMs);
+        }
+        else if (arg == "--grid" && i + 1 < argc) {
+            argsValid &= parseArg("--grid", argv[++i], gridSize);
+            gridSize = std::max(gridSize, 0);
+        }
+        else if (arg == "--no-instancing") instancing = false;
+        else if (arg == "--no-persistent") persistentRing = false;
+        else if (arg == "--grid-depth") gridDepth = true;
+        else if (arg == "--occlusion") occlusionCulling = true;
+        else if (arg == "--gpu-culling") gpuCulling = true;
+        else if (arg == "--occlusion-queries") occlusionQueries = true;
+        else if (arg == "--normals" && i + 1 < argc) {
+            // --normals angle|area|angle-area: 平滑法线加权方式
+            if (!parseNormalWeighting(argv[++i], loadOptions.normalWeighting))
+                std::cout << "Unknown normal weighting: " << argv[i] << std::endl;
+        }
+        else if (arg == "--vertex-format" && i + 1 < argc) {
+            // --vertex-format float|q16-oct16|q16-packed: GPU 顶点格式
+            if (!parseVertexFormat(argv[++i], loadOptions.vertexFormat))
+                std::cout << "Unknown vertex format: " << argv[i] << std::endl;
+        }
+        else if (arg == "--lod-threshold" || arg == "--upload-budget" || arg == "--grid" || arg == "--normals" ||
+                 arg == "--vertex-format") {
+            std::cout << "Missing value for " << arg << std::endl;
+            argsValid = false;
+        }
+        else argv[positional++] = argv[i];
+    }
+    argc = positional;
+    // 第四个位置参数：覆盖材质预设的粗糙度
+    float roughness = 0.0f;
+    if (argc > 4) argsValid &= parseArg("roughness", argv[4], roughness);
+    if (!argsValid) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -48,39 +177,58 @@ int main(int argc, char** argv) {
         return -1;
     }    
 
-    glEnable(GL_DEPTH_TEST);    
+    glState().setEnabled(GL_DEPTH_TEST, true);
 
-    Shader phong_shader(std::string(SHADER_DIR) + "/phong-vertex.vs",
-                  std::string(SHADER_DIR) + "/phong-fragment.fs");
-    
-    Shader gouraud_shader(std::string(SHADER_DIR) + "/gouraud-vertex.vs",
-                  std::string(SHADER_DIR) + "/gouraud-fragment.fs");
+    // 程序按需编译：启动时只构建所选着色模型，其余在首帧后于后台预热
+    loadGLExtensions();
+    ShaderManager shaders(SHADER_DIR, separableShaders);
 
-    // Cook-Torrance (PBR) shader
-    Shader cook_shader(std::string(SHADER_DIR) + "/cooktorrance-vertex.vs",
-                  std::string(SHADER_DIR) + "/cooktorrance-fragment.fs");
-    
-    int vertexCount = 0;
     std::string objName = "cube";
     if(argc > 1) objName = argv[1];
     std::string objPath = std::string(TEST_DIR) + "/" + objName + ".obj";
-    std::vector<float> vertices = loadOBJ(objPath, vertexCount);
+    // 网格在工作线程中加载，主线程先绘制包围盒占位，加载完成后分帧上传
+    AsyncMeshLoader loader;
+    loader.start(objPath, loadOptions, useMeshCache, flatMesh);
 
-    unsigned int VBO, VAO;
+    unsigned int VBO, VAO, EBO = 0;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    if (!flatMesh) glGenBuffers(1, &EBO);
+    // 包围盒占位：12 条边的线段，法线由中心指向角点
+    unsigned int boxVAO, boxVBO;
+    glGenVertexArrays(1, &boxVAO);
+    glGenBuffers(1, &boxVBO);
+    bool boxReady = false;
+    // --grid：模型与包围盒占位都按实例绘制，实例属性挂在两个 VAO 上
+    const bool instanced = gridSize > 0 && instancing;
+    const bool separateObjects = gridSize > 0 && !instancing;
+    const GLsizei instanceCount = instanced ? gridSize * gridSize : 1;
+    InstanceArrays instances;
+    InstanceBuffer instanceBuffer;
+    if (instanced) {
+        instanceBuffer.create(static_cast<size_t>(instanceCount));
+        instanceBuffer.attach(VAO);
+        instanceBuffer.attach(boxVAO);
+        glState().bindVertexArray(0);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    float instanceSpacing = 0.0f;
 
-    // 设置顶点属性指针: layout(0)=pos, layout(1)=normal
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0); 
-    glBindVertexArray(0);    
+    int vertexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    // 量化顶点的反量化参数（浮点布局为恒等变换）
+    glm::vec3 posScale(1.0f), posOffset(0.0f);
+    int normalEnc = 0;
+    // 模型空间包围球，用于 LOD 的屏幕空间误差估计
+    glm::vec3 boundsCenter(0.0f);
+    glm::vec3 boundsExtent(0.0f); // 模型空间 AABB 半长
+    float boundsRadius = 0.0f;
+    UploadQueue uploads;
+    bool uploading = false, meshResident = false, loadFailed = false;
+    // 加载期间（首帧到网格就绪）的帧统计
+    int loadingFrames = 0;
+    double maxLoadingFrameMs = 0.0;
+    auto lastFrameTime = std::chrono::steady_clock::now();
 
     // render loop
     // -----------
@@ -88,67 +236,22 @@ int main(int argc, char** argv) {
     glm::vec3 lightPos(4.0f, 4.0f, 4.0f);
     glm::vec3 viewPos(0.0f, 0.0f, 4.0f);
     glm::vec3 lightcolor(1.0f, 1.0f, 1.0f);
-    glm::vec3 objcolor(0.0f, 0.5f, 1.5f);
-    glm::vec3 F0(0.15f, 0.15f, 0.15f);
-    glm::vec3 albedo(0.15f, 0.15f, 0.15f);
-    glm::float32 ambient(0.2f);
-    glm::float32 specular(0.5f);
-    glm::float32 shininess(60.0f);
-    glm::float32 metallic(1.0f);
-    // parameters used by Cook-Torrance shader
-    float roughness = 0.35f;
     glm::mat4 rot = glm::mat4(1.0f);
-    auto shader = &phong_shader;
+    ShadingModel shadingModel = SHADING_PHONG;
+    char materialId = '0';
     
     if(argc > 2) {
         if(argv[2][0] == '1') {
-            shader = &gouraud_shader;       // Gouraud
+            shadingModel = SHADING_GOURAUD;       // Gouraud
         } else if(argv[2][0] == '2') {
-            shader = &cook_shader;      // Cook-Torrance
-            ambient = 0.1f;
+            shadingModel = SHADING_COOK_TORRANCE;      // Cook-Torrance
             lightcolor = glm::vec3(3.0f, 3.0f, 3.0f);
         }
-        if(argc > 3) {
-            if(argv[3][0] == '1') { //铜
-                objcolor = F0 = glm::vec3(0.955f, 0.638f, 0.538f);
-                metallic = 1.0f;
-                albedo = glm::vec3(1.0f, 0.8f, 0.6f);
-                roughness = 0.2f;
-            } else if(argv[3][0] == '2') { //银
-                objcolor = F0 = glm::vec3(0.660f, 0.670f, 0.680f);
-                metallic = 1.0f;
-                albedo = glm::vec3(0.9f, 0.9f, 0.9f);
-                roughness = 0.4;
-            } else if(argv[3][0] == '3') { //皮革
-                objcolor = albedo = glm::vec3(0.23f, 0.12f, 0.05f);
-                F0 = glm::vec3(0.04f, 0.04f, 0.04f);
-                metallic = 0.0f;
-                roughness = 0.5f;
-            } else if(argv[3][0] == '4') { //铁
-                objcolor = F0 = glm::vec3(0.560f, 0.570f, 0.580f);
-                metallic = 1.0f;
-                albedo = glm::vec3(0.65f, 0.65f, 0.65f);
-                roughness = 0.3f;
-            } else if(argv[3][0] == '5') { //碳（石墨）
-                objcolor = F0 = glm::vec3(0.04f, 0.04f, 0.04f);
-                metallic = 0.0f;
-                albedo = glm::vec3(0.05f, 0.05f, 0.05f);
-                roughness = 0.8f;
-            } else if(argv[3][0] == '6') { //金
-                objcolor = F0 = glm::vec3(1.022f, 0.782f, 0.344f);
-                metallic = 1.0f;
-                albedo = glm::vec3(1.0f, 0.85f, 0.57f);
-                roughness = 0.3f;
-            } else if(argv[3][0] == '7') { //锡
-                objcolor = F0 = glm::vec3(0.549f, 0.556f, 0.554f);
-                metallic = 1.0f;
-                albedo = glm::vec3(0.75f, 0.75f, 0.75f);
-                roughness = 0.25f;
-            }
-        }
-        if(argc > 4) {
-            roughness = std::stof(argv[4]);
-        }
+        if(argc > 3) materialId = argv[3][0];
+    }
+    MaterialBlock material = materialPreset(materialId, shadingModel);
+    if(argc > 4) {
+        material.roughness = roughness;
     }
 
     if(argc > 1 && (std::string)argv[1] == "dinosaur") {
@@ -163,8 +266,135 @@ int main(int argc, char** argv) {
         lightPos = glm::vec3(4.0f, 4.0f, 4.0f);
         lightcolor = glm::vec3(0.8f, 0.8f, 0.8f);
     }
+    // 实例材质表：首项为所选材质，其后依次为后续预设；多于一个实例时沿网格对角线循环使用
+    MaterialTableBlock materialTable = MaterialTableBlock();
+    const unsigned materialCount = gridSize > 1 ? kMaxInstanceMaterials : 1;
+    const int firstPreset = (materialId >= '0' && materialId <= '7') ? materialId - '0' : 0;
+    materialTable.materials[0] = material;
+    for (unsigned k = 1; k < kMaxInstanceMaterials; ++k) {
+        char id = static_cast<char>('0' + (firstPreset + k) % kMaxInstanceMaterials);
+        materialTable.materials[k] = materialPreset(id, shadingModel);
+    }
+    // 按材质参数选择最省的精确着色器变体（如金属度恰为 1 时去掉漫反射）；实例化时须对所用材质都精确
+    // 按需开启的特性：近似菲涅尔与逐顶点法线矩阵
+    const unsigned optInFeatures = (fastFresnel ? static_cast<unsigned>(SHADER_FAST_FRESNEL) : 0u) |
+                                   (shaderTransforms ? static_cast<unsigned>(SHADER_VERTEX_NORMAL_MATRIX) : 0u);
+    auto featuresFor = [&](ShadingModel m) {
+        return instanced ? shaderFeaturesFor(m, materialTable.materials, materialCount, optInFeatures) |
+                               static_cast<unsigned>(SHADER_INSTANCED)
+                         : shaderFeaturesFor(m, material, optInFeatures);
+    };
+    unsigned shaderFeatures = featuresFor(shadingModel);
+    Shader* shader = NULL;
+    // 各材质所用的程序：独立物体的混合材质场景中每种材质按自身参数选择变体，否则都用同一个程序
+    std::vector<Shader*> materialShaders(materialCount);
+    auto selectShaders = [&]() {
+        shader = &shaders.get(shadingModel, shaderFeatures);
+        for (unsigned k = 0; k < materialCount; ++k) {
+            materialShaders[k] = separateObjects
+                ? &shaders.get(shadingModel, shaderFeaturesFor(shadingModel, materialTable.materials[k], optInFeatures))
+                : shader;
+        }
+    };
+    selectShaders();
+    std::cout << "Shader variant: " << ShaderManager::describe(shadingModel, shaderFeatures) << std::endl;
+    ObjectUniforms objectUniforms;
+    int warmFrames = -1; // 首帧后开始预热其余程序，完成时输出所用帧数
+    // 光源与材质在所有程序间共享，经 uniform 缓冲一次写入；帧数据每帧更新（未变化时跳过上传）
+    UniformBuffer frameUBO, lightUBO, materialUBO, materialTableUBO;
+    frameUBO.create(kFrameBlockBinding, sizeof(FrameBlock));
+    lightUBO.create(kLightBlockBinding, sizeof(LightBlock));
+    materialUBO.create(kMaterialBlockBinding, sizeof(MaterialBlock), materialCount);
+    if (instanced) {
+        materialTableUBO.create(kMaterialTableBinding, sizeof(MaterialTableBlock));
+        materialTableUBO.update(0, materialTable);
+        materialTableUBO.bind();
+    }
+    LightBlock light = LightBlock();
+    light.position = lightPos;
+    light.color = lightcolor;
+    lightUBO.update(0, light);
+    for (unsigned k = 0; k < materialCount; ++k) materialUBO.update(k, materialTable.materials[k]);
+    frameUBO.bind();
+    lightUBO.bind();
+    materialUBO.bind();
+    // 每帧动态数据（帧 uniform 块、实例数据）写入持久映射的三帧环形缓冲，GPU 未读完的区域以 fence 保护
+    DynamicRingBuffer ring;
+    if (persistentRing && !ring.create(4096 + (instanced ? instanceBuffer.bytes() : 0))) {
+        std::cout << "Dynamic ring: persistent mapping unavailable, using glBufferSubData" << std::endl;
+    }
+    // --gpu-culling：实例排布常驻 GPU，CPU 每帧只传模型矩阵；剔除、压缩与绘制命令都在 GPU 上生成，
+    // 每帧的 CPU 开销与 GL 调用数都与实例数无关
+    GpuCuller gpuCuller;
+    InstanceArrays instanceLayout;
+    bool layoutUploaded = false;
+    float layoutSpacing = 0.0f; // 上传时的间距与行方向，变化时重新上传
+    glm::vec3 layoutRowAxis(0.0f);
+    GLuint gpuVAO = 0;
+    bool gpuCullingEnabled = false;
+    if (gpuCulling) {
+        if (!instanced || flatMesh) {
+            std::cout << "GPU culling: requires instanced --grid with an indexed mesh, using CPU culling" << std::endl;
+        } else if (!gpuCuller.create(std::string(SHADER_DIR) + "/", static_cast<size_t>(instanceCount))) {
+            std::cout << "GPU culling: compute shaders or multi-draw indirect unavailable, using CPU culling"
+                      << std::endl;
+        } else {
+            gpuCullingEnabled = true;
+        }
+    }
+    bool firstFrame = true;
+    // 单个物体与 --no-instancing：逐物体的 LOD 选择与簇剔除，命令引用的范围数组由 meshDraws 保留到下一帧
+    MeshDrawSelector meshDraws;
+    std::vector<DrawCommand> objectDraws;
+    // 各子系统的统计逐帧累加，首帧与之后每秒输出一次每帧平均（见循环末尾）后清零
+    double reportTime = glfwGetTime();
+    unsigned reportFrames = 0;
+    MeshletCullTotals meshletStats = MeshletCullTotals();
+    // --gpu-timing：关闭光栅化重绘一次完整网格，得到仅顶点阶段的 GPU 耗时
+    GpuTimer vertexTimer;
+    // --grid：网格就绪后的 CPU 帧耗时与实例数据更新耗时
+    InstanceTotals instanceStats = InstanceTotals();
+    // 视锥剔除：物体按世界空间 AABB、簇按模型空间包围球批量测试；--occlusion 时物体再经软件遮挡剔除
+    ObjectCuller objectCuller;
+    InstanceArrays visibleInstances;
+    FrustumCullTotals cullStats = FrustumCullTotals();
+    // 硬件遮挡查询：只用于几何足够重的独立物体（包围盒查询比直接绘制便宜得多时才划算）
+    const size_t kMinQueryTriangles = 256;
+    OcclusionQueries hwOcclusion;
+    // 查询逐物体跳过绘制：单个物体没有遮挡者，实例化网格的所有实例共用一次绘制，都无从跳过
+    if (occlusionQueries && gridSize == 0) {
+        std::cout << "Occlusion queries: disabled for a single object, nothing can occlude it"
+                  << " (use --grid <N> --no-instancing)" << std::endl;
+    } else if (occlusionQueries && instanced) {
+        std::cout << "Occlusion queries: disabled for an instanced --grid, one draw covers every instance"
+                  << " so a query cannot skip one (use --no-instancing, or --gpu-culling for Hi-Z culling)"
+                  << std::endl;
+    }
+    // 每帧的绘制项经渲染队列排序后提交；独立物体各有一份变换
+    RenderQueue queue;
+    std::vector<ObjectTransform> objectTransforms;
+    // 网格较大时相机后移，远近平面随之放大
+    float nearPlane = 0.1f, farPlane = 300.0f;
     while (!glfwWindowShouldClose(window)) {
         processInput(window);
+        // 数字键 1-3 切换着色模型（已预热的程序无需等待编译）
+        for (int m = 0; m < kShadingModelCount; ++m) {
+            if (m != shadingModel && glfwGetKey(window, GLFW_KEY_1 + m) == GLFW_PRESS) {
+                shadingModel = static_cast<ShadingModel>(m);
+                shaderFeatures = featuresFor(shadingModel);
+                selectShaders();
+                std::cout << "Shader variant: " << ShaderManager::describe(shadingModel, shaderFeatures) << std::endl;
+            }
+        }
+        if (warmFrames >= 0 && !shaders.idle()) {
+            shaders.update();
+            ++warmFrames;
+            if (shaders.idle()) {
+                std::cout << "Shaders: all programs ready after " << warmFrames << " frames ("
+                          << shaders.programCount() << " programs, " << shaders.stageCount() << " compiled stages, "
+                          << (shaders.separable() ? "separable" : "monolithic") << ")" << std::endl;
+            }
+        }
         float time = static_cast<float>(glfwGetTime());
         // 视口尺寸
         int fbw, fbh;
@@ -175,37 +405,351 @@ int main(int argc, char** argv) {
         model = model * rot;
         glm::mat4 view  = glm::translate(glm::mat4(1.0f), -viewPos);
         view = glm::rotate(view, 0.4f, glm::vec3(1.0f, 0.0f, 0.0f));
-        glm::mat4 proj  = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 300.0f);
-        glm::mat4 mvp   = proj * view * model;
+        glm::mat4 proj  = glm::perspective(glm::radians(45.0f), aspect, nearPlane, farPlane);
+        // MVP 与法线矩阵逐物体在 CPU 上计算一次
+        ObjectTransform transform;
+        computeTransforms(proj * view, &model, 1, &transform);
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // 绘制模型
-        shader->use();
-        shader->setMat4("uMVP", mvp);
-        shader->setMat4("uModel", model);
-
-        shader->setVec3("uLightPos", lightPos);
-        shader->setVec3("uViewPos", viewPos);
-        shader->setVec3("uLightColor", lightcolor);
-        shader->setVec3("uObjectColor", objcolor);
-        shader->setFloat("uAmbient", ambient);
-        shader->setFloat("uSpecular", specular);
-        shader->setFloat("uShininess", shininess);
-        shader->setFloat("uMetallic", metallic);
-        // Cook-Torrance uniforms (no-op for other shaders)
-        shader->setVec3("F0", F0);
-        shader->setVec3("uAlbedo", albedo);
-        shader->setFloat("uRoughness", roughness);
-        glBindVertexArray(VAO); 
-        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        // 包围盒在解析出位置后即可用（缓存命中时在加载结束时）
+        if (!boxReady) {
+            glm::vec3 lo, hi;
+            if (loader.bounds(lo, hi)) {
+                std::vector<float> box = boundingBoxLines(lo, hi);
+                glState().bindVertexArray(boxVAO);
+                glState().bindBuffer(GL_ARRAY_BUFFER, boxVBO);
+                glBufferData(GL_ARRAY_BUFFER, box.size() * sizeof(float), box.data(), GL_STATIC_DRAW);
+                setupVertexLayout(VertexLayout::positionNormal());
+                glState().bindVertexArray(0);
+                glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+                boundsCenter = (lo + hi) * 0.5f;
+                boundsExtent = (hi - lo) * 0.5f;
+                boundsRadius = glm::length(hi - lo) * 0.5f;
+                objectCuller.setBounds(boundsCenter, boundsExtent);
+                boxReady = true;
+                // 实例绕各自原点旋转，间距按旋转扫过的半径留出余量；相机后移到能看到整个网格
+                instanceSpacing = 2.2f * (glm::length(boundsCenter) + boundsRadius);
+                if (gridSize > 1) {
+                    float extent = instanceSpacing * gridSize;
+                    if (gridDepth) {
+                        // 行沿视线排开：相机置于第一行前两个间距处，近处几列占满画面，后排被前排遮挡
+                        viewPos.z = 0.5f * instanceSpacing * (gridSize - 1) + 2.0f * instanceSpacing;
+                    } else {
+                        viewPos.z += 0.55f * extent / std::tan(glm::radians(22.5f));
+                    }
+                    farPlane = std::max(farPlane, 2.0f * (glm::length(viewPos) + extent));
+                    nearPlane = std::max(nearPlane, farPlane / 3000.0f);
+                }
+            }
+        }
+        // 加载完成后开始上传：分配存储并设置顶点布局，数据按帧预算分片写入
+        if (!uploading && !meshResident && !loadFailed && loader.finished()) {
+            if (!loader.succeeded()) {
+                std::cout << "ERROR: Failed to load mesh: " << objPath << std::endl;
+                loadFailed = true;
+            } else {
+                const MeshBuffers &mb = loader.buffers();
+                glState().bindVertexArray(VAO);
+                uploads.add(VBO, mb.vertexData, mb.vertexBytes);
+                glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+                setupVertexLayout(mb.layout);
+                if (flatMesh) {
+                    vertexCount = static_cast<int>(mb.vertexCount);
+                } else {
+                    // EBO 绑定记录在 VAO 中；索引宽度按顶点数自动选择 16/32 位
+                    uploads.add(EBO, mb.indexData, mb.indexBytes);
+                    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+                    indexType = (mb.indexSize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+                    posScale = mb.positionScale;
+                    posOffset = mb.positionOffset;
+                    normalEnc = normalEncoding(mb.layout);
+                    meshDraws.setMesh(mb, meshletCulling, lodThreshold, boundsCenter, boundsRadius);
+                    if (gpuCullingEnabled) {
+                        // 与 VAO 共用顶点与索引缓冲，实例属性改为指向剔除输出
+                        glGenVertexArrays(1, &gpuVAO);
+                        glState().bindVertexArray(gpuVAO);
+                        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+                        setupVertexLayout(mb.layout);
+                        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+                        GpuCullMesh cullMesh = GpuCullMesh();
+                        cullMesh.vao = gpuVAO;
+                        cullMesh.indexType = indexType;
+                        cullMesh.indexSize = mb.indexSize;
+                        cullMesh.indexCount = mb.indexCount;
+                        cullMesh.lods = meshDraws.lods().empty() ? NULL : meshDraws.lods().data();
+                        cullMesh.lodCount = static_cast<unsigned>(meshDraws.lods().size());
+                        cullMesh.lodThreshold = lodThreshold;
+                        cullMesh.boundsCenter = boundsCenter;
+                        cullMesh.boundsExtent = boundsExtent;
+                        cullMesh.boundsRadius = boundsRadius;
+                        gpuCuller.setMesh(cullMesh);
+                    }
+                }
+                if (occlusionCulling && gridSize > 1) {
+                    if (objectCuller.setOccluder(mb)) {
+                        const OccluderMesh &occluder = objectCuller.occluder();
+                        std::cout << "Occlusion: occluder " << occluder.triangleCount() << " triangles, "
+                                  << occluder.positions.size() << " vertices" << std::endl;
+                    } else {
+                        std::cout << "Occlusion: no simplified occluder geometry, occlusion culling disabled"
+                                  << std::endl;
+                    }
+                }
+                if (occlusionQueries && separateObjects) {
+                    size_t triangles =
+                        (flatMesh ? mb.vertexCount : (mb.lodCount ? mb.lods[0].indexCount : mb.indexCount)) / 3;
+                    if (triangles < kMinQueryTriangles) {
+                        std::cout << "Occlusion queries: mesh has " << triangles << " triangles (< "
+                                  << kMinQueryTriangles << "), not worth querying, disabled" << std::endl;
+                    } else if (!hwOcclusion.create(std::string(SHADER_DIR) + "/", boundsCenter - boundsExtent,
+                                                   boundsCenter + boundsExtent,
+                                                   static_cast<size_t>(gridSize) * gridSize)) {
+                        std::cout << "Occlusion queries: failed to build the bounding box program, disabled"
+                                  << std::endl;
+                    }
+                }
+                glState().bindVertexArray(0);
+                glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+                uploading = true;
+            }
+        }
+        if (uploading) {
+            uploads.step(uploadBudgetMs);
+            if (uploads.empty()) {
+                // 数据已上传，释放 CPU 侧副本与缓存映射
+                loader.release();
+                uploading = false;
+                meshResident = true;
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+                std::cout << "Mesh resident after " << ms << " ms (load " << loader.loadMs() << " ms"
+                          << (flatMesh ? "" : (loader.cacheHit() ? ", mesh cache hit" : ", mesh cache miss")) << ", "
+                          << uploads.bytesUploaded() / (1024.0 * 1024.0) << " MB uploaded; " << loadingFrames
+                          << " frames while loading, max frame " << maxLoadingFrameMs << " ms)" << std::endl;
+            }
+        }
+        ring.beginFrame();
+        const bool gpuDriven = gpuCuller.ready() && meshResident;
+        // --grid-depth：行沿世界空间中的视线方向（相机 -Z 轴）
+        const glm::vec3 rowAxis =
+            gridDepth ? -glm::normalize(glm::vec3(glm::inverse(view)[2])) : glm::vec3(0.0f, 1.0f, 0.0f);
+        // 逐实例变换（SoA）每帧整体重算；独立物体时同样排布，但逐物体计算 MVP。GPU 剔除时由着色器合成
+        if ((instanced || separateObjects) && boxReady && !gpuDriven) {
+            auto t0 = std::chrono::steady_clock::now();
+            layoutInstanceGrid(instances, gridSize, instanceSpacing, model, materialCount, rowAxis);
+            if (meshResident) {
+                instanceStats.updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            }
+        }
+        // 逐物体剔除（视锥与遮挡）；GPU 剔除时只在排布变化时上传实例
+        GLsizei drawInstances = instanceCount;
+        const glm::vec3 cameraWorld = glm::vec3(glm::inverse(view)[3]);
+        if (gpuDriven) {
+            // 剔除在 GPU 上进行：只含格点平移与材质的排布常驻实例缓冲（自有存储，不经环形缓冲），排布变化时才上传
+            if (!layoutUploaded || instanceSpacing != layoutSpacing || rowAxis != layoutRowAxis) {
+                auto t0 = std::chrono::steady_clock::now();
+                layoutInstanceGrid(instanceLayout, gridSize, instanceSpacing, glm::mat4(1.0f), materialCount, rowAxis);
+                instanceBuffer.update(instanceLayout);
+                layoutUploaded = true;
+                layoutSpacing = instanceSpacing;
+                layoutRowAxis = rowAxis;
+                instanceStats.updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            }
+        } else if (boxReady) {
+            const bool grid = instanced || separateObjects;
+            unsigned visible = objectCuller.cull(proj * view, cameraWorld, grid ? instances.model.data() : &model,
+                                                 grid ? instances.size() : 1, meshResident ? &cullStats : NULL);
+            if (instanced) {
+                // 只上传可见实例
+                auto t0 = std::chrono::steady_clock::now();
+                objectCuller.compact(instances, visibleInstances);
+                instanceBuffer.update(visibleInstances, &ring);
+                drawInstances = static_cast<GLsizei>(visible);
+                if (meshResident) {
+                    instanceStats.updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                }
+            }
+        }
+        if (separateObjects) {
+            objectTransforms.resize(boxReady ? instances.size() : 0);
+            if (boxReady) computeTransforms(proj * view, instances.model.data(), instances.size(), objectTransforms.data());
+        } else {
+            objectTransforms.assign(1, transform);
+        }
+        FrameBlock frame = FrameBlock();
+        frame.view = view;
+        frame.proj = proj;
+        frame.viewPos = viewPos;
+        RingAllocation frameAlloc = ring.allocateUniform(sizeof(FrameBlock));
+        if (frameAlloc.data) {
+            memcpy(frameAlloc.data, &frame, sizeof(FrameBlock));
+            glState().bindBufferRange(GL_UNIFORM_BUFFER, kFrameBlockBinding, frameAlloc.buffer,
+                                      static_cast<GLintptr>(frameAlloc.offset), sizeof(FrameBlock));
+        } else {
+            frameUBO.update(0, frame);
+            frameUBO.bind();
+        }
+        // 本帧各物体共用的绘制命令：加载期间为包围盒线框，之后为模型；
+        // 单个物体与独立物体各自选择 LOD、剔除簇，命令在 objectDraws 中
+        const float pixelScale = static_cast<float>(fbh) / (2.0f * std::tan(glm::radians(45.0f) * 0.5f));
+        DrawCommand meshDraw = DrawCommand();
+        GLuint meshVAO = VAO;
+        bool drawMesh = false;
+        bool perObjectDraws = false;
+        if (!meshResident) {
+            if (boxReady) {
+                meshDraw = arrayDraw(GL_LINES, 0, 24, drawInstances);
+                meshVAO = boxVAO;
+                drawMesh = true;
+            }
+        } else if (flatMesh) {
+            meshDraw = arrayDraw(GL_TRIANGLES, 0, vertexCount, drawInstances);
+            drawMesh = true;
+        } else if (instanced) {
+            // 实例化时所有实例共用一次绘制，只能绘制完整网格：簇剔除与 LOD 选择只用于单个物体与 --no-instancing
+            meshDraw = indexedDraw(GL_TRIANGLES, indexType, meshDraws.fullIndexCount(), 0, drawInstances);
+            drawMesh = true;
+        } else {
+            // 以各自的 MVP 与模型空间相机位置选择 LOD、剔除簇（视锥 / 遮挡剔除掉的物体跳过）
+            const std::vector<uint8_t> &visible = objectCuller.visible();
+            objectDraws.assign(objectTransforms.size(), DrawCommand());
+            meshDraws.beginFrame(objectTransforms.size(), pixelScale);
+            for (size_t i = 0; i < objectTransforms.size(); ++i) {
+                if (i < visible.size() && !visible[i]) continue;
+                const ObjectTransform &t = objectTransforms[i];
+                glm::vec3 cameraPos = glm::vec3(glm::inverse(t.model) * glm::vec4(cameraWorld, 1.0f));
+                objectDraws[i] = meshDraws.select(i, t.mvp, cameraPos);
+            }
+            meshDraws.endFrame(cullStats, meshletStats);
+            drawMesh = perObjectDraws = true;
+        }
+        if (meshResident && !gpuDriven) ++cullStats.frames;
+        if (gpuDriven) {
+            // 阶段 0：上一帧可见的实例
+            gpuCuller.beginFrame(proj * view, model, cameraWorld, pixelScale, instanceBuffer, instanceLayout.size(),
+                                 fbw, fbh);
+            gpuCuller.cull(0);
+        }
+        // 收取之前帧的查询结果（不等待）
+        const bool queriesActive = hwOcclusion.ready() && meshResident;
+        if (queriesActive) hwOcclusion.beginFrame();
+        // 每个物体提交一个绘制项，键按 程序 / 材质 / VAO / 由近到远 排序
+        queue.clear();
+        if (gpuDriven) {
+            gpuCuller.submit(queue, materialShaders[0]);
+        } else if (drawMesh && drawInstances > 0) {
+            // 实例化时唯一的绘制项已只含可见实例
+            const std::vector<uint8_t> &visible = objectCuller.visible();
+            ObjectBatch batch = ObjectBatch();
+            batch.transforms = objectTransforms.data();
+            batch.count = objectTransforms.size();
+            batch.visible = !instanced && visible.size() >= batch.count ? visible.data() : NULL;
+            batch.draws = perObjectDraws ? objectDraws.data() : NULL;
+            batch.draw = meshDraw;
+            batch.materials = separateObjects ? instances.material.data() : NULL;
+            batch.vao = meshVAO;
+            submitObjects(queue, batch, materialShaders, queriesActive ? &hwOcclusion : NULL, boundsCenter,
+                          cameraWorld, farPlane);
+        }
+        queue.sort();
+        auto setObject = [&](const RenderItem& item, bool programChanged) {
+            if (programChanged) objectUniforms = lookupObjectUniforms(*item.shader);
+            const ObjectTransform &t = objectTransforms[item.object];
+            item.shader->set(objectUniforms.mvp, t.mvp);
+            item.shader->set(objectUniforms.model, t.model);
+            item.shader->set(objectUniforms.normalMatrix, t.normal);
+            item.shader->set(objectUniforms.posScale, meshResident ? posScale : glm::vec3(1.0f));
+            item.shader->set(objectUniforms.posOffset, meshResident ? posOffset : glm::vec3(0.0f));
+            item.shader->set(objectUniforms.normalEncoding, meshResident ? normalEnc : 0);
+        };
+        if (gpuDriven) {
+            gpuCuller.execute(queue, materialUBO, setObject);
+        } else {
+            queue.execute(materialUBO, setObject);
+        }
+        // 不透明物体都已写入深度：为到期的物体发出包围盒查询，结果供之后的帧使用
+        if (queriesActive) hwOcclusion.issue(objectTransforms.data(), objectTransforms.size());
+        if (gpuTiming && meshResident) {
+            // 裁剪到 1 像素并关闭写入后把本帧绘制再执行一遍：片元几乎全部被丢弃，耗时只剩顶点着色与图元装配
+            // （不用 GL_RASTERIZER_DISCARD，部分驱动在丢弃光栅化时会跳过顶点着色）
+            vertexTimer.begin();
+            glState().setEnabled(GL_SCISSOR_TEST, true);
+            glState().scissor(0, 0, 1, 1);
+            glState().colorMask(false);
+            glState().depthMask(false);
+            queue.execute(materialUBO, setObject);
+            glState().depthMask(true);
+            glState().colorMask(true);
+            glState().setEnabled(GL_SCISSOR_TEST, false);
+            vertexTimer.end();
+            vertexTimer.collect();
+        }
+        ring.endFrame();
+        ++reportFrames;
+        const double reportNow = glfwGetTime();
+        if (firstFrame || reportNow - reportTime >= 1.0) {
+            Shader::uniformStats().report(std::cout, reportFrames);
+            Shader::resetUniformStats();
+            glState().stats().report(std::cout, reportFrames);
+            glState().resetStats();
+            queue.report(std::cout);
+            queue.resetStats();
+            ring.stats().report(std::cout);
+            ring.resetStats();
+            vertexTimer.report(std::cout, "vertex stage");
+            vertexTimer.reset();
+            meshletStats.report(std::cout);
+            meshletStats.reset();
+            cullStats.report(std::cout);
+            cullStats.reset();
+            objectCuller.occlusionStats().report(std::cout);
+            objectCuller.resetOcclusionStats();
+            hwOcclusion.stats().report(std::cout);
+            hwOcclusion.resetStats();
+            if (gpuDriven) gpuCuller.report(std::cout, instanceLayout.size());
+            if (instanced) {
+                const long long triangles = static_cast<long long>(instanceCount) *
+                                            (flatMesh ? vertexCount : meshDraws.fullIndexCount()) / 3;
+                instanceStats.report(std::cout, static_cast<size_t>(instanceCount), triangles);
+                instanceStats.reset();
+            }
+            reportTime = reportNow;
+            reportFrames = 0;
+        }
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (firstFrame) {
+            firstFrame = false;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            std::cout << "Startup: first frame after " << ms << " ms" << std::endl;
+            for (int m = 0; m < kShadingModelCount; ++m) {
+                ShadingModel other = static_cast<ShadingModel>(m);
+                shaders.warm(other, featuresFor(other));
+            }
+            warmFrames = 0;
+        }
+        auto frameEnd = std::chrono::steady_clock::now();
+        if (!meshResident) {
+            ++loadingFrames;
+            maxLoadingFrameMs = std::max(maxLoadingFrameMs,
+                                         std::chrono::duration<double, std::milli>(frameEnd - lastFrameTime).count());
+        }
+        if (meshResident) {
+            instanceStats.frameMs += std::chrono::duration<double, std::milli>(frameEnd - lastFrameTime).count();
+            ++instanceStats.frames;
+        }
+        lastFrameTime = frameEnd;
+        // 加载线程运行期间让出时间片，核心数少（或无垂直同步）时避免主线程空转饿死加载线程
+        if (!loader.finished()) std::this_thread::yield();
     }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    glState().deleteVertexArray(VAO);
+    glState().deleteBuffer(VBO);
+    glState().deleteBuffer(EBO);
+    glState().deleteVertexArray(boxVAO);
+    glState().deleteVertexArray(gpuVAO);
+    glState().deleteBuffer(boxVBO);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -213,6 +757,105 @@ int main(int argc, char** argv) {
     return 0;
 }
 
+// 每个物体提交一个绘制项（被剔除、已知被遮挡或簇全部被剔除的物体跳过），键按 程序 / 材质 / VAO / 由近到远；
+// queries 非 NULL 时由其决定是否提交以及条件渲染所用的查询
+// ---------------------------------------------------------------------------------------------------------
+void submitObjects(RenderQueue& queue, const ObjectBatch& batch, const std::vector<Shader*>& materialShaders,
+                   OcclusionQueries* queries, const glm::vec3& boundsCenter, const glm::vec3& camera, float farPlane)
+{
+    for (size_t i = 0; i < batch.count; ++i) {
+        bool candidate = !batch.visible || batch.visible[i];
+        GLuint condition = 0;
+        if (queries) candidate = queries->select(i, candidate, condition);
+        if (!candidate) continue;
+        const DrawCommand &draw = batch.draws ? batch.draws[i] : batch.draw;
+        if (draw.count == 0 && draw.drawCount == 0) continue;
+        RenderItem item = RenderItem();
+        item.condition = condition;
+        item.material = batch.materials ? batch.materials[i] : 0;
+        item.shader = materialShaders[item.material];
+        item.vao = batch.vao;
+        item.object = static_cast<unsigned>(i);
+        item.draw = draw;
+        glm::vec3 center = glm::vec3(batch.transforms[i].model * glm::vec4(boundsCenter, 1.0f));
+        item.key = makeSortKey(RENDER_PASS_OPAQUE, queue.programIndex(item.shader), item.material, item.vao,
+                               glm::length(center - camera) / farPlane);
+        queue.submit(item);
+    }
+}
+
+// 程序链接后反射出的 uniform 句柄，渲染循环中不再按名字查找
+// ---------------------------------------------------------------------------------------------------------
+ObjectUniforms lookupObjectUniforms(const Shader& shader)
+{
+    ObjectUniforms u;
+    u.mvp = shader.uniform<glm::mat4>("uMVP");
+    u.model = shader.uniform<glm::mat4>("uModel");
+    u.normalMatrix = shader.uniform<glm::mat3>("uNormalMatrix");
+    u.posScale = shader.uniform<glm::vec3>("uPosScale");
+    u.posOffset = shader.uniform<glm::vec3>("uPosOffset");
+    u.normalEncoding = shader.uniform<int>("uNormalEncoding");
+    return u;
+}
+
+// 预定义材质（第三个参数 '0'-'7'），其余字符为默认材质；Cook-Torrance 下环境光较弱
+// ---------------------------------------------------------------------------------------------
+MaterialBlock materialPreset(char id, ShadingModel model)
+{
+    glm::vec3 objcolor(0.0f, 0.5f, 1.5f);
+    glm::vec3 F0(0.15f, 0.15f, 0.15f);
+    glm::vec3 albedo(0.15f, 0.15f, 0.15f);
+    glm::float32 metallic(1.0f);
+    // parameters used by Cook-Torrance shader
+    float roughness = 0.35f;
+    if(id == '1') { //铜
+        objcolor = F0 = glm::vec3(0.955f, 0.638f, 0.538f);
+        metallic = 1.0f;
+        albedo = glm::vec3(1.0f, 0.8f, 0.6f);
+        roughness = 0.2f;
+    } else if(id == '2') { //银
+        objcolor = F0 = glm::vec3(0.660f, 0.670f, 0.680f);
+        metallic = 1.0f;
+        albedo = glm::vec3(0.9f, 0.9f, 0.9f);
+        roughness = 0.4;
+    } else if(id == '3') { //皮革
+        objcolor = albedo = glm::vec3(0.23f, 0.12f, 0.05f);
+        F0 = glm::vec3(0.04f, 0.04f, 0.04f);
+        metallic = 0.0f;
+        roughness = 0.5f;
+    } else if(id == '4') { //铁
+        objcolor = F0 = glm::vec3(0.560f, 0.570f, 0.580f);
+        metallic = 1.0f;
+        albedo = glm::vec3(0.65f, 0.65f, 0.65f);
+        roughness = 0.3f;
+    } else if(id == '5') { //碳（石墨）
+        objcolor = F0 = glm::vec3(0.04f, 0.04f, 0.04f);
+        metallic = 0.0f;
+        albedo = glm::vec3(0.05f, 0.05f, 0.05f);
+        roughness = 0.8f;
+    } else if(id == '6') { //金
+        objcolor = F0 = glm::vec3(1.022f, 0.782f, 0.344f);
+        metallic = 1.0f;
+        albedo = glm::vec3(1.0f, 0.85f, 0.57f);
+        roughness = 0.3f;
+    } else if(id == '7') { //锡
+        objcolor = F0 = glm::vec3(0.549f, 0.556f, 0.554f);
+        metallic = 1.0f;
+        albedo = glm::vec3(0.75f, 0.75f, 0.75f);
+        roughness = 0.25f;
+    }
+    MaterialBlock material = MaterialBlock();
+    material.objectColor = objcolor;
+    material.ambient = (model == SHADING_COOK_TORRANCE) ? 0.1f : 0.2f;
+    material.albedo = albedo;
+    material.roughness = roughness;
+    material.F0 = F0;
+    material.metallic = metallic;
+    material.specular = 0.5f;
+    material.shininess = 60.0f;
+    return material;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
@@ -221,11 +864,109 @@ void processInput(GLFWwindow *window)
         glfwSetWindowShouldClose(window, true);
 }
 
+// 命令行用法（选项的完整说明见 README.md）
+// ---------------------------------------------------------------------------------------------
+void printUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [model] [0|1|2] [material 0-7] [roughness] [--option ...]" << std::endl
+              << "  numeric options: --lod-threshold <px> --upload-budget <ms> --grid <N>; see README.md for the rest"
+              << std::endl;
+}
+
+// 数值参数：整个字符串须为范围内的有限数值，否则输出参数名与原文并返回 false（value 不变）
+// ---------------------------------------------------------------------------------------------
+bool parseArg(const char* name, const char* text, float& value)
+{
+    char* end = NULL;
+    errno = 0;
+    const float v = std::strtof(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(v)) {
+        std::cout << "Invalid value for " << name << ": " << text << std::endl;
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+bool parseArg(const char* name, const char* text, double& value)
+{
+    char* end = NULL;
+    errno = 0;
+    const double v = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(v)) {
+        std::cout << "Invalid value for " << name << ": " << text << std::endl;
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+bool parseArg(const char* name, const char* text, int& value)
+{
+    char* end = NULL;
+    errno = 0;
+    const long v = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX) {
+        std::cout << "Invalid value for " << name << ": " << text << std::endl;
+        return false;
+    }
+    value = static_cast<int>(v);
+    return true;
+}
+
+// 按布局描述设置当前 VAO 的顶点属性指针（需已绑定 VAO 与 VBO）
+// ---------------------------------------------------------------------------------------------
+void setupVertexLayout(const VertexLayout& layout)
+{
+    for (uint32_t i = 0; i < layout.attribCount; ++i) {
+        const VertexAttrib &a = layout.attribs[i];
+        GLenum type = GL_FLOAT;
+        GLboolean normalized = GL_FALSE;
+        switch (a.type) {
+        case ATTRIB_FLOAT32: type = GL_FLOAT; normalized = GL_FALSE; break;
+        case ATTRIB_UNORM16: type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; break;
+        case ATTRIB_SNORM16: type = GL_SHORT; normalized = GL_TRUE; break;
+        case ATTRIB_SNORM_2_10_10_10: type = GL_INT_2_10_10_10_REV; normalized = GL_TRUE; break;
+        }
+        glVertexAttribPointer(a.location, a.components, type, normalized, layout.stride, (void*)(uintptr_t)a.offset);
+        glEnableVertexAttribArray(a.location);
+    }
+}
+
+// 包围盒 12 条边的线段顶点（pos + normal 交错），法线由中心指向角点，供加载期间占位绘制
+// ---------------------------------------------------------------------------------------------
+std::vector<float> boundingBoxLines(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i) {
+        corners[i] = glm::vec3((i & 1) ? boundsMax.x : boundsMin.x,
+                               (i & 2) ? boundsMax.y : boundsMin.y,
+                               (i & 4) ? boundsMax.z : boundsMin.z);
+    }
+    std::vector<float> lines;
+    lines.reserve(24 * 6);
+    for (int i = 0; i < 8; ++i) {
+        for (int axis = 1; axis < 8; axis <<= 1) {
+            if (i & axis) continue; // 每条边只从较小的角点出发
+            const int ends[2] = {i, i | axis};
+            for (int e = 0; e < 2; ++e) {
+                const glm::vec3 &p = corners[ends[e]];
+                glm::vec3 n = p - center;
+                float len = glm::length(n);
+                if (len > 0.0f) n /= len;
+                lines.insert(lines.end(), {p.x, p.y, p.z, n.x, n.y, n.z});
+            }
+        }
+    }
+    return lines;
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "mesh.h"
+
+#include <cstring>
+
+VertexLayout VertexLayout::positionNormal() {
+    VertexLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.stride = 6 * sizeof(float);
+    layout.attribCount = 2;
+    layout.attribs[0].location = 0;
+    layout.attribs[0].components = 3;
+    layout.attribs[0].type = ATTRIB_FLOAT32;
+    layout.attribs[0].offset = 0;
+    layout.attribs[1].location = 1;
+    layout.attribs[1].components = 3;
+    layout.attribs[1].type = ATTRIB_FLOAT32;
+    layout.attribs[1].offset = 3 * sizeof(float);
+    return layout;
+}
+
+std::vector<unsigned char> Mesh::packedIndices() const {
+    std::vector<unsigned char> out(indices.size() * indexSize());
+    if (indices.empty()) return out;
+    if (indexSize() == 4) {
+        memcpy(out.data(), indices.data(), out.size());
+    } else {
+        uint16_t *dst = reinterpret_cast<uint16_t *>(out.data());
+        for (size_t i = 0; i < indices.size(); ++i) dst[i] = static_cast<uint16_t>(indices[i]);
+    }
+    return out;
+}
+
+void Mesh::computeBounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    if (vertices.empty()) {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+        return;
+    }
+    boundsMin = boundsMax = glm::vec3(vertices[0], vertices[1], vertices[2]);
+    for (size_t i = 0; i + 5 < vertices.size(); i += 6) {
+        glm::vec3 p(vertices[i], vertices[i + 1], vertices[i + 2]);
+        boundsMin = glm::min(boundsMin, p);
+        boundsMax = glm::max(boundsMax, p);
+    }
+}
+
+MeshBuffers makeMeshBuffers(const Mesh& mesh, const std::vector<unsigned char>& packedIndices) {
+    MeshBuffers b;
+    b.layout = VertexLayout::positionNormal();
+    b.vertexData = mesh.vertices.data();
+    b.vertexBytes = mesh.vertices.size() * sizeof(float);
+    b.vertexCount = static_cast<unsigned>(mesh.vertexCount());
+    b.indexData = packedIndices.data();
+    b.indexBytes = packedIndices.size();
+    b.indexCount = static_cast<unsigned>(mesh.indexCount());
+    b.indexSize = mesh.indexSize();
+    mesh.computeBounds(b.boundsMin, b.boundsMax);
+    b.positionScale = glm::vec3(1.0f);
+    b.positionOffset = glm::vec3(0.0f);
+    b.meshlets = mesh.meshlets.data();
+    b.meshletCount = static_cast<unsigned>(mesh.meshlets.size());
+    b.lods = mesh.lods.data();
+    b.lodCount = static_cast<unsigned>(mesh.lods.size());
+    return b;
+}
@@ -0,0 +1,289 @@
+#include "meshcache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+#include "hash.h"
+#include "simplify.h"
+
+namespace {
+
+const char kMagic[8] = {'P', 'S', 'M', 'E', 'S', 'H', 0, 0};
+
+bool statSource(const std::string& path, uint64_t& size, int64_t& mtimeNs) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) return false;
+    mtimeNs = static_cast<int64_t>(st.st_mtime) * 1000000000LL;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+#ifdef __APPLE__
+    mtimeNs = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+#endif
+    size = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+bool hashSource(const std::string& path, uint64_t& hash) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    hash = hash64(file.data(), file.size());
+    return true;
+}
+
+// 影响缓存内容的加载选项；新增影响输出的选项时需加入此处
+uint64_t optionsHash(const ObjLoadOptions& options) {
+    std::string key = "normals=";
+    key += normalWeightingName(options.normalWeighting);
+    key += options.optimize ? ";optimize=vcache,overdraw,fetch" : ";optimize=none";
+    key += ";lod=";
+    if (options.lods) {
+        for (size_t i = 0; i < kLodRatioCount; ++i) key += std::to_string(kLodRatios[i]) + ",";
+    } else {
+        key += "none";
+    }
+    key += ";format=";
+    key += vertexFormatName(options.vertexFormat);
+    return hash64(key);
+}
+
+inline uint64_t alignUp(uint64_t v) {
+    return (v + kMeshCacheAlign - 1) / kMeshCacheAlign * kMeshCacheAlign;
+}
+
+// [offset, offset + bytes) 落在 size 字节之内；先比较 offset，避免相加溢出
+inline bool fitsIn(uint64_t offset, uint64_t bytes, uint64_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+// 属性占用的字节数，分量数与类型不匹配时为 0
+uint32_t attribBytes(const VertexAttrib& a) {
+    if (a.components < 1 || a.components > 4) return 0;
+    switch (a.type) {
+    case ATTRIB_FLOAT32: return a.components * 4;
+    case ATTRIB_UNORM16:
+    case ATTRIB_SNORM16: return a.components * 2;
+    case ATTRIB_SNORM_2_10_10_10: return a.components == 4 ? 4 : 0;
+    }
+    return 0;
+}
+
+// 布局描述可直接交给 glVertexAttribPointer：位置在 GL 保证的 16 个以内、
+// 分量数与类型有效、每个属性都落在 stride 之内
+bool validLayout(const VertexLayout& layout) {
+    if (layout.stride == 0 || layout.attribCount == 0 || layout.attribCount > VertexLayout::kMaxAttribs) {
+        return false;
+    }
+    for (uint32_t i = 0; i < layout.attribCount; ++i) {
+        const VertexAttrib &a = layout.attribs[i];
+        const uint32_t bytes = attribBytes(a);
+        if (a.location >= 16 || bytes == 0 || !fitsIn(a.offset, bytes, layout.stride)) return false;
+    }
+    return true;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void printVertexFormat(const ObjLoadOptions& options, const MeshBuffers& buffers, const QuantizationError& error) {
+    std::cout << "Vertex format: " << vertexFormatName(options.vertexFormat) << ", "
+              << buffers.layout.stride << " bytes/vertex";
+    if (options.vertexFormat != VERTEX_FLOAT32) {
+        std::cout << " (float: " << VertexLayout::positionNormal().stride << "), max position error "
+                  << error.position << " (" << error.positionRel << " of bounds), max normal error "
+                  << error.normalDegrees << " deg";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+std::string meshCachePath(const std::string& sourcePath) {
+    return sourcePath + ".pmesh";
+}
+
+bool MeshCache::open(const std::string& cachePath, const std::string& sourcePath, const ObjLoadOptions& options) {
+    close();
+    if (!file_.open(cachePath)) return false;
+
+    MeshCacheHeader h;
+    if (file_.size() < sizeof(h)) {
+        close();
+        return false;
+    }
+    memcpy(&h, file_.data(), sizeof(h));
+
+    // 结构校验
+    const uint64_t fileSize = file_.size();
+    bool ok = memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+              h.version == kMeshCacheVersion &&
+              h.headerSize == sizeof(MeshCacheHeader) &&
+              validLayout(h.layout) &&
+              (h.indexSize == 2 || h.indexSize == 4) &&
+              h.vertexOffset % kMeshCacheAlign == 0 && h.indexOffset % kMeshCacheAlign == 0 &&
+              fitsIn(h.vertexOffset, h.vertexBytes, fileSize) && fitsIn(h.indexOffset, h.indexBytes, fileSize) &&
+              h.vertexBytes == static_cast<uint64_t>(h.vertexCount) * h.layout.stride &&
+              h.indexBytes == static_cast<uint64_t>(h.indexCount) * h.indexSize &&
+              h.meshletOffset % kMeshCacheAlign == 0 && fitsIn(h.meshletOffset, h.meshletBytes, fileSize) &&
+              h.meshletBytes == static_cast<uint64_t>(h.meshletCount) * sizeof(Meshlet) &&
+              h.lodCount <= kMaxLods;
+    for (uint32_t i = 0; ok && i < h.lodCount; ++i) {
+        ok = static_cast<uint64_t>(h.lods[i].indexOffset) + h.lods[i].indexCount <= h.indexCount;
+    }
+    // 簇范围必须落在索引缓冲内
+    const Meshlet *meshlets = reinterpret_cast<const Meshlet *>(file_.data() + h.meshletOffset);
+    for (uint32_t i = 0; ok && i < h.meshletCount; ++i) {
+        ok = static_cast<uint64_t>(meshlets[i].indexOffset) + meshlets[i].triangleCount * 3ull <= h.indexCount;
+    }
+    if (!ok) {
+        std::cout << "Mesh cache invalid, rebuilding: " << cachePath << std::endl;
+        close();
+        return false;
+    }
+
+    // 新鲜度校验：大小必须一致；修改时间不同则比较内容哈希
+    uint64_t srcSize = 0;
+    int64_t srcMtime = 0;
+    if (h.optionsHash != optionsHash(options) || !statSource(sourcePath, srcSize, srcMtime) ||
+        srcSize != h.sourceSize) {
+        close();
+        return false;
+    }
+    if (srcMtime != h.sourceMtime) {
+        uint64_t srcHash = 0;
+        if (!hashSource(sourcePath, srcHash) || srcHash != h.sourceHash) {
+            close();
+            return false;
+        }
+    }
+
+    buffers_.layout = h.layout;
+    buffers_.vertexData = file_.data() + h.vertexOffset;
+    buffers_.vertexBytes = static_cast<size_t>(h.vertexBytes);
+    buffers_.vertexCount = h.vertexCount;
+    buffers_.indexData = file_.data() + h.indexOffset;
+    buffers_.indexBytes = static_cast<size_t>(h.indexBytes);
+    buffers_.indexCount = h.indexCount;
+    buffers_.indexSize = h.indexSize;
+    buffers_.meshlets = meshlets;
+    buffers_.meshletCount = h.meshletCount;
+    buffers_.lods = reinterpret_cast<const MeshCacheHeader *>(file_.data())->lods;
+    buffers_.lodCount = h.lodCount;
+    buffers_.boundsMin = glm::vec3(h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]);
+    buffers_.boundsMax = glm::vec3(h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]);
+    buffers_.positionScale = glm::vec3(h.positionScale[0], h.positionScale[1], h.positionScale[2]);
+    buffers_.positionOffset = glm::vec3(h.positionOffset[0], h.positionOffset[1], h.positionOffset[2]);
+    error_.position = h.positionError;
+    error_.normalDegrees = h.normalError;
+    const glm::vec3 extent = buffers_.boundsMax - buffers_.boundsMin;
+    const float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+    error_.positionRel = maxExtent > 0.0f ? h.positionError / maxExtent : 0.0f;
+    return true;
+}
+
+bool writeMeshCache(const std::string& cachePath, const std::string& sourcePath,
+                    const ObjLoadOptions& options, const MeshBuffers& buffers,
+                    const QuantizationError& error) {
+    MeshCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kMeshCacheVersion;
+    h.headerSize = sizeof(MeshCacheHeader);
+    if (!statSource(sourcePath, h.sourceSize, h.sourceMtime) || !hashSource(sourcePath, h.sourceHash)) {
+        return false;
+    }
+    h.optionsHash = optionsHash(options);
+    h.layout = buffers.layout;
+    for (int i = 0; i < 3; ++i) {
+        h.boundsMin[i] = buffers.boundsMin[i];
+        h.boundsMax[i] = buffers.boundsMax[i];
+        h.positionScale[i] = buffers.positionScale[i];
+        h.positionOffset[i] = buffers.positionOffset[i];
+    }
+    h.positionError = error.position;
+    h.normalError = error.normalDegrees;
+    h.vertexCount = buffers.vertexCount;
+    h.indexCount = buffers.indexCount;
+    h.indexSize = buffers.indexSize;
+    h.vertexOffset = alignUp(sizeof(h));
+    h.vertexBytes = buffers.vertexBytes;
+    h.indexOffset = alignUp(h.vertexOffset + h.vertexBytes);
+    h.indexBytes = buffers.indexBytes;
+    h.meshletCount = buffers.meshletCount;
+    h.lodCount = std::min(buffers.lodCount, kMaxLods);
+    for (uint32_t i = 0; i < h.lodCount; ++i) h.lods[i] = buffers.lods[i];
+    h.meshletOffset = alignUp(h.indexOffset + h.indexBytes);
+    h.meshletBytes = static_cast<uint64_t>(buffers.meshletCount) * sizeof(Meshlet);
+
+    const std::string tmpPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        const std::vector<char> zeros(kMeshCacheAlign, 0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(zeros.data(), static_cast<std::streamsize>(h.vertexOffset - sizeof(h)));
+        out.write(static_cast<const char*>(buffers.vertexData), static_cast<std::streamsize>(h.vertexBytes));
+        out.write(zeros.data(), static_cast<std::streamsize>(h.indexOffset - h.vertexOffset - h.vertexBytes));
+        out.write(static_cast<const char*>(buffers.indexData), static_cast<std::streamsize>(h.indexBytes));
+        out.write(zeros.data(), static_cast<std::streamsize>(h.meshletOffset - h.indexOffset - h.indexBytes));
+        out.write(reinterpret_cast<const char*>(buffers.meshlets), static_cast<std::streamsize>(h.meshletBytes));
+        if (!out.good()) {
+            out.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(cachePath.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadOBJCached(const std::string& filename, const ObjLoadOptions& options, bool useCache,
+                   MeshCache& cache, Mesh& mesh, PackedMesh& packed,
+                   MeshBuffers& buffers, bool& cacheHit) {
+    buffers = MeshBuffers();
+    cacheHit = false;
+    const std::string cachePath = meshCachePath(filename);
+    auto t0 = std::chrono::steady_clock::now();
+    if (useCache && cache.open(cachePath, filename, options)) {
+        buffers = cache.buffers();
+        cacheHit = true;
+        double ms = elapsedMs(t0);
+        double mb = (buffers.vertexBytes + buffers.indexBytes) / (1024.0 * 1024.0);
+        std::cout << "Loaded mesh cache: " << cachePath << std::endl;
+        const unsigned baseIndices = buffers.lodCount ? buffers.lods[0].indexCount : buffers.indexCount;
+        std::cout << "Vertices: " << buffers.vertexCount << ", Triangles: " << baseIndices / 3
+                  << ", Meshlets: " << buffers.meshletCount << ", LODs: " << buffers.lodCount << ", " << mb << " MB in " << ms << " ms" << std::endl;
+        printVertexFormat(options, buffers, cache.quantizationError());
+        return true;
+    }
+
+    if (!loadOBJMesh(filename, mesh, options)) return false;
+    QuantizationError error;
+    buffers = packMesh(mesh, options.vertexFormat, packed, &error);
+    printVertexFormat(options, buffers, error);
+    if (useCache) {
+        if (writeMeshCache(cachePath, filename, options, buffers, error)) {
+            std::cout << "Wrote mesh cache: " << cachePath << std::endl;
+        } else {
+            std::cout << "WARNING: Cannot write mesh cache: " << cachePath << std::endl;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#include "meshdraws.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+MeshDrawSelector::MeshDrawSelector()
+    : indexType_(GL_UNSIGNED_INT), indexSize_(4), indexCount_(0), lodThreshold_(0.0f), boundsCenter_(0.0f),
+      boundsRadius_(0.0f), objectCount_(0), pixelScale_(1.0f), frameCull_(), frameRanges_(0), frameMs_(0.0),
+      currentLod_(-1) {}
+
+void MeshDrawSelector::setMesh(const MeshBuffers& mb, bool cullMeshlets, float lodThreshold,
+                               const glm::vec3& boundsCenter, float boundsRadius) {
+    indexType_ = (mb.indexSize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    indexSize_ = mb.indexSize;
+    indexCount_ = mb.indexCount;
+    meshlets_.clear();
+    if (cullMeshlets) {
+        meshlets_.assign(mb.meshlets, mb.meshlets + mb.meshletCount);
+        meshletSpheres(meshlets_.data(), static_cast<unsigned>(meshlets_.size()), meshletBounds_);
+    }
+    lods_.assign(mb.lods, mb.lods + mb.lodCount);
+    lodThreshold_ = lodThreshold;
+    boundsCenter_ = boundsCenter;
+    boundsRadius_ = boundsRadius;
+}
+
+GLsizei MeshDrawSelector::fullIndexCount() const {
+    return static_cast<GLsizei>(lods_.empty() ? indexCount_ : lods_[0].indexCount);
+}
+
+void MeshDrawSelector::beginFrame(size_t objectCount, float pixelScale) {
+    objectCount_ = objectCount;
+    pixelScale_ = pixelScale;
+    if (draws_.size() < objectCount) draws_.resize(objectCount);
+    frameCull_ = MeshletCullStats();
+    frameRanges_ = 0;
+    frameMs_ = 0.0;
+}
+
+int MeshDrawSelector::selectLod(const glm::vec3& cameraPos, float& errorPixels) const {
+    float pixelsPerUnit = pixelScale_ / std::max(glm::length(cameraPos - boundsCenter_) - boundsRadius_, 0.1f);
+    int lod = 0;
+    while (lod + 1 < static_cast<int>(lods_.size()) && lods_[lod + 1].error * pixelsPerUnit <= lodThreshold_) ++lod;
+    errorPixels = lods_[lod].error * pixelsPerUnit;
+    return lod;
+}
+
+DrawCommand MeshDrawSelector::select(size_t object, const glm::mat4& mvp, const glm::vec3& cameraPos) {
+    int lod = 0;
+    if (lods_.size() > 1 && lodThreshold_ > 0.0f) {
+        float errorPixels = 0.0f;
+        lod = selectLod(cameraPos, errorPixels);
+        if (objectCount_ == 1 && lod != currentLod_) {
+            std::cout << "LOD: level " << lod << " (" << lods_[lod].indexCount / 3 << " triangles, error "
+                      << errorPixels << " px)" << std::endl;
+            currentLod_ = lod;
+        }
+    }
+    if (lod > 0) {
+        return indexedDraw(GL_TRIANGLES, indexType_, static_cast<GLsizei>(lods_[lod].indexCount),
+                           static_cast<uintptr_t>(lods_[lod].indexOffset) * indexSize_);
+    }
+    if (meshlets_.empty()) return indexedDraw(GL_TRIANGLES, indexType_, fullIndexCount(), 0);
+
+    MeshletDrawList &draws = draws_[object];
+    MeshletCullStats cull;
+    auto c0 = std::chrono::steady_clock::now();
+    cullMeshlets(meshlets_.data(), meshletBounds_, static_cast<unsigned>(meshlets_.size()), indexSize_, mvp,
+                 cameraPos, draws, cull);
+    frameMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - c0).count();
+    frameCull_.total += cull.total;
+    frameCull_.frustumCulled += cull.frustumCulled;
+    frameCull_.backfaceCulled += cull.backfaceCulled;
+    frameRanges_ += static_cast<unsigned>(draws.counts.size());
+    if (draws.counts.empty()) return DrawCommand();
+    return multiIndexedDraw(GL_TRIANGLES, indexType_, draws.counts.data(), draws.offsets.data(),
+                            static_cast<GLsizei>(draws.counts.size()));
+}
+
+void MeshDrawSelector::endFrame(FrustumCullTotals& cullStats, MeshletCullTotals& meshletStats) const {
+    cullStats.chunksCulled += frameCull_.frustumCulled + frameCull_.backfaceCulled;
+    cullStats.chunksVisible += frameCull_.total - frameCull_.frustumCulled - frameCull_.backfaceCulled;
+    cullStats.ms += frameMs_;
+    meshletStats.add(frameCull_, frameRanges_);
+}
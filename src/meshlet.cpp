@@ -0,0 +1,235 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "frustum.h"
+#include "mesh.h"
+#include "threadpool.h"
+
+namespace {
+
+const float kMinConeDot = 0.1f; // 簇内法线与锥轴最小夹角余弦低于此值时不做锥剔除
+
+inline glm::vec3 vertexPosition(const Mesh& mesh, unsigned int v) {
+    const float *p = &mesh.vertices[static_cast<size_t>(v) * 6];
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// 按位置焊接后检查每条有向边是否恰有一条反向边与之配对（封闭且朝向一致）
+bool isClosedMesh(const Mesh& mesh) {
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    std::vector<unsigned int> order(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) order[i] = static_cast<unsigned int>(i);
+    std::sort(order.begin(), order.end(), [&mesh](unsigned int a, unsigned int b) {
+        const float *pa = &mesh.vertices[static_cast<size_t>(a) * 6];
+        const float *pb = &mesh.vertices[static_cast<size_t>(b) * 6];
+        return std::lexicographical_compare(pa, pa + 3, pb, pb + 3);
+    });
+    std::vector<unsigned int> weld(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        bool same = i > 0 && memcmp(&mesh.vertices[static_cast<size_t>(order[i]) * 6],
+                                    &mesh.vertices[static_cast<size_t>(order[i - 1]) * 6], 3 * sizeof(float)) == 0;
+        weld[order[i]] = same ? weld[order[i - 1]] : order[i];
+    }
+
+    std::vector<uint64_t> edges, reversed;
+    edges.reserve(mesh.indices.size());
+    reversed.reserve(mesh.indices.size());
+    for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint64_t a = weld[mesh.indices[t + k]], b = weld[mesh.indices[t + (k + 1) % 3]];
+            if (a == b) continue;
+            edges.push_back((a << 32) | b);
+            reversed.push_back((b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::sort(reversed.begin(), reversed.end());
+    return edges == reversed;
+}
+
+void computeBounds(const Mesh& mesh, bool allowCone, Meshlet& m) {
+    const unsigned int *idx = &mesh.indices[m.indexOffset];
+    const size_t cornerCount = static_cast<size_t>(m.triangleCount) * 3;
+
+    // 包围球：包围盒中心 + 最远顶点距离
+    glm::vec3 lo = vertexPosition(mesh, idx[0]), hi = lo;
+    for (size_t i = 1; i < cornerCount; ++i) {
+        glm::vec3 p = vertexPosition(mesh, idx[i]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    glm::vec3 center = (lo + hi) * 0.5f;
+    float radius2 = 0.0f;
+    for (size_t i = 0; i < cornerCount; ++i) {
+        glm::vec3 d = vertexPosition(mesh, idx[i]) - center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    for (int i = 0; i < 3; ++i) m.center[i] = center[i];
+    m.radius = std::sqrt(radius2);
+
+    // 法线锥：轴为单位面法线均值，半角由最偏离轴的面法线决定
+    m.coneCutoff = 1.0f;
+    for (int i = 0; i < 3; ++i) m.coneApex[i] = m.coneAxis[i] = 0.0f;
+    if (!allowCone) return;
+    glm::vec3 axis(0.0f);
+    std::vector<glm::vec3> normals(m.triangleCount, glm::vec3(0.0f));
+    for (unsigned t = 0; t < m.triangleCount; ++t) {
+        glm::vec3 p0 = vertexPosition(mesh, idx[t * 3]);
+        glm::vec3 c = glm::cross(vertexPosition(mesh, idx[t * 3 + 1]) - p0, vertexPosition(mesh, idx[t * 3 + 2]) - p0);
+        float len = glm::length(c);
+        if (len <= 0.0f) continue; // 退化三角形不可见，不约束锥
+        normals[t] = c / len;
+        axis += normals[t];
+    }
+    float axisLen = glm::length(axis);
+    if (axisLen <= 0.0f) return;
+    axis /= axisLen;
+
+    float minDot = 1.0f;
+    for (unsigned t = 0; t < m.triangleCount; ++t) {
+        if (normals[t] != glm::vec3(0.0f)) minDot = std::min(minDot, glm::dot(axis, normals[t]));
+    }
+    if (minDot <= kMinConeDot) return;
+
+    // 锥顶：沿轴反向移动到所有三角形平面的背面
+    float maxT = 0.0f;
+    for (unsigned t = 0; t < m.triangleCount; ++t) {
+        if (normals[t] == glm::vec3(0.0f)) continue;
+        glm::vec3 p0 = vertexPosition(mesh, idx[t * 3]);
+        float dc = glm::dot(center - p0, normals[t]);
+        float dn = glm::dot(axis, normals[t]);
+        maxT = std::max(maxT, dc / dn);
+    }
+    glm::vec3 apex = center - axis * maxT;
+    for (int i = 0; i < 3; ++i) {
+        m.coneApex[i] = apex[i];
+        m.coneAxis[i] = axis[i];
+    }
+    m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+} // namespace
+
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh) {
+    std::vector<Meshlet> meshlets;
+    const size_t triCount = mesh.indices.size() / 3;
+    if (triCount == 0) return meshlets;
+
+    // 贪心切分：加入下一个三角形会超出顶点或三角形上限时开始新簇
+    std::vector<unsigned int> mark(static_cast<size_t>(mesh.vertexCount()), ~0u);
+    Meshlet current;
+    memset(&current, 0, sizeof(current));
+    unsigned id = 0;
+    for (size_t t = 0; t < triCount; ++t) {
+        const unsigned int *tri = &mesh.indices[t * 3];
+        unsigned added = 0;
+        for (int k = 0; k < 3; ++k) {
+            bool seen = mark[tri[k]] == id || (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (!seen) ++added;
+        }
+        if (current.triangleCount == kMeshletMaxTriangles || current.vertexCount + added > kMeshletMaxVertices) {
+            meshlets.push_back(current);
+            memset(&current, 0, sizeof(current));
+            current.indexOffset = static_cast<uint32_t>(t * 3);
+            ++id;
+            added = 0;
+            for (int k = 0; k < 3; ++k) {
+                if (!((k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]))) ++added;
+            }
+        }
+        for (int k = 0; k < 3; ++k) mark[tri[k]] = id;
+        current.vertexCount += added;
+        current.triangleCount++;
+    }
+    meshlets.push_back(current);
+
+    const bool closed = isClosedMesh(mesh);
+    ThreadPool::shared().parallelFor(meshlets.size(), [&](size_t i) {
+        computeBounds(mesh, closed, meshlets[i]);
+    });
+    return meshlets;
+}
+
+void meshletSpheres(const Meshlet* meshlets, unsigned count, SphereArrays& spheres) {
+    spheres.resize(count);
+    for (unsigned i = 0; i < count; ++i) {
+        spheres.x[i] = meshlets[i].center[0];
+        spheres.y[i] = meshlets[i].center[1];
+        spheres.z[i] = meshlets[i].center[2];
+        spheres.radius[i] = meshlets[i].radius;
+    }
+}
+
+void cullMeshlets(const Meshlet* meshlets, const SphereArrays& spheres, unsigned count, unsigned indexSize,
+                  const glm::mat4& mvp, const glm::vec3& cameraPos,
+                  MeshletDrawList& draws, MeshletCullStats& stats) {
+    draws.counts.clear();
+    draws.offsets.clear();
+    stats.total = count;
+    stats.frustumCulled = stats.backfaceCulled = 0;
+
+    const Frustum frustum = Frustum::fromMatrix(mvp);
+    draws.visible.resize(count);
+    frustum.cullSpheres(spheres, draws.visible.data());
+    uint32_t runBegin = 0, runEnd = 0; // 当前合并中的可见索引区间
+    bool inRun = false;
+    for (unsigned i = 0; i < count; ++i) {
+        const Meshlet &m = meshlets[i];
+        if (m.coneCutoff < 1.0f) {
+            glm::vec3 view = glm::vec3(m.coneApex[0], m.coneApex[1], m.coneApex[2]) - cameraPos;
+            float len = glm::length(view);
+            if (len > 0.0f &&
+                glm::dot(view, glm::vec3(m.coneAxis[0], m.coneAxis[1], m.coneAxis[2])) >= m.coneCutoff * len) {
+                stats.backfaceCulled++;
+                continue;
+            }
+        }
+        if (!draws.visible[i]) {
+            stats.frustumCulled++;
+            continue;
+        }
+        const uint32_t begin = m.indexOffset, end = m.indexOffset + m.triangleCount * 3;
+        if (inRun && begin == runEnd) {
+            runEnd = end;
+            continue;
+        }
+        if (inRun) {
+            draws.counts.push_back(static_cast<int>(runEnd - runBegin));
+            draws.offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(runBegin) * indexSize));
+        }
+        runBegin = begin;
+        runEnd = end;
+        inRun = true;
+    }
+    if (inRun) {
+        draws.counts.push_back(static_cast<int>(runEnd - runBegin));
+        draws.offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(runBegin) * indexSize));
+    }
+}
+
+void MeshletCullTotals::add(const MeshletCullStats& stats, unsigned drawCount) {
+    if (!stats.total) return;
+    const float culled = 100.0f * (stats.frustumCulled + stats.backfaceCulled) / stats.total;
+    culledMin = frames ? std::min(culledMin, culled) : culled;
+    culledMax = frames ? std::max(culledMax, culled) : culled;
+    culledSum += culled;
+    total += stats.total;
+    frustumCulled += stats.frustumCulled;
+    backfaceCulled += stats.backfaceCulled;
+    draws += drawCount;
+    meshlets = stats.total;
+    ++frames;
+}
+
+void MeshletCullTotals::report(std::ostream& out) const {
+    if (!frames) return;
+    const float t = static_cast<float>(total);
+    out << "Meshlets: " << meshlets << ", culled per frame " << culledSum / frames << "% (min " << culledMin
+        << "%, max " << culledMax << "%; backface " << 100.0f * backfaceCulled / t << "%, frustum "
+        << 100.0f * frustumCulled / t << "%), " << static_cast<float>(draws) / frames << " draws/frame over "
+        << frames << " frames" << std::endl;
+}
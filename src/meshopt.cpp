@@ -0,0 +1,284 @@
+#include "meshopt.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+// FIFO 顶点缓存模拟：时间戳差不超过 cacheSize 即在缓存中
+class FifoCache {
+public:
+    FifoCache(size_t vertexCount, unsigned cacheSize)
+        : stamps_(vertexCount, 0), cacheSize_(cacheSize), time_(cacheSize + 1) {}
+
+    // 引用顶点 v，未命中时返回 true 并将其压入缓存
+    bool touch(unsigned int v) {
+        if (time_ - stamps_[v] > cacheSize_) {
+            stamps_[v] = time_++;
+            return true;
+        }
+        return false;
+    }
+
+    // 清空缓存：推进时间使所有时间戳失效
+    void reset() { time_ += cacheSize_ + 1; }
+
+    // 顶点 v 在缓存中的“年龄”，不在缓存中时大于 cacheSize
+    uint64_t age(unsigned int v) const { return time_ - stamps_[v]; }
+
+private:
+    std::vector<uint64_t> stamps_;
+    uint64_t cacheSize_;
+    uint64_t time_;
+};
+
+unsigned missesForTriangle(FifoCache& cache, const unsigned int *tri) {
+    return (cache.touch(tri[0]) ? 1u : 0u) + (cache.touch(tri[1]) ? 1u : 0u) + (cache.touch(tri[2]) ? 1u : 0u);
+}
+
+// 顶点 → 相邻三角形 表（CSR）
+struct TriangleAdjacency {
+    std::vector<unsigned int> offsets; // vertexCount + 1
+    std::vector<unsigned int> triangles;
+};
+
+void buildAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount, TriangleAdjacency& adj) {
+    adj.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indices.size(); ++i) adj.offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v) adj.offsets[v + 1] += adj.offsets[v];
+    adj.triangles.resize(indices.size());
+    std::vector<unsigned int> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) adj.triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+}
+
+inline glm::vec3 positionAt(const float* vertices, size_t stride, unsigned int v) {
+    const float *p = vertices + static_cast<size_t>(v) * stride;
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    stats.acmr = stats.atvr = 0.0f;
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    size_t misses = 0, usedCount = 0;
+    for (size_t t = 0; t < triCount; ++t) {
+        misses += missesForTriangle(cache, &indices[t * 3]);
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = indices[t * 3 + k];
+            if (!used[v]) {
+                used[v] = true;
+                ++usedCount;
+            }
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / triCount;
+    stats.atvr = static_cast<float>(misses) / usedCount;
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize,
+                         std::vector<unsigned int>* clusters) {
+    const size_t triCount = indices.size() / 3;
+    if (clusters) clusters->assign(1, 0);
+    if (triCount == 0 || vertexCount == 0) return;
+
+    TriangleAdjacency adj;
+    buildAdjacency(indices, vertexCount, adj);
+
+    // live[v]: 顶点 v 尚未输出的相邻三角形数
+    std::vector<unsigned int> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) live[v] = adj.offsets[v + 1] - adj.offsets[v];
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> emitted(triCount, false);
+    std::vector<unsigned int> deadEnd;   // 最近输出的顶点栈，用于跳出死角
+    std::vector<unsigned int> candidates; // 当前扇面的 1-ring 顶点
+    std::vector<unsigned int> out;
+    out.reserve(triCount * 3);
+    deadEnd.reserve(triCount * 3);
+    size_t cursor = 0;
+
+    long long fan = indices[0];
+    while (fan >= 0) {
+        // 输出扇面顶点所有未输出的相邻三角形
+        candidates.clear();
+        const unsigned int f = static_cast<unsigned int>(fan);
+        for (unsigned int a = adj.offsets[f]; a < adj.offsets[f + 1]; ++a) {
+            unsigned int t = adj.triangles[a];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                cache.touch(v);
+            }
+        }
+
+        // 选择下一个扇面顶点：优先仍在缓存中、且输出其剩余三角形后不会被挤出的最老顶点
+        long long next = -1;
+        uint64_t best = 0;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            unsigned int v = candidates[i];
+            if (live[v] == 0) continue;
+            uint64_t priority = 0;
+            if (cache.age(v) + 2 * static_cast<uint64_t>(live[v]) <= cacheSize) priority = cache.age(v);
+            if (next < 0 || priority > best) {
+                best = priority;
+                next = v;
+            }
+        }
+
+        if (next < 0) {
+            // 死角：先回溯最近输出的顶点，再按顺序扫描；此处缓存局部性中断，记为硬边界
+            while (!deadEnd.empty() && next < 0) {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0) next = v;
+            }
+            while (next < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0) next = static_cast<long long>(cursor);
+                else ++cursor;
+            }
+            unsigned int boundary = static_cast<unsigned int>(out.size() / 3);
+            if (clusters && next >= 0 && boundary != clusters->back()) clusters->push_back(boundary);
+        }
+        fan = next;
+    }
+
+    indices.swap(out);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusters,
+                      const float* vertices, size_t stride, size_t vertexCount,
+                      float threshold, unsigned cacheSize) {
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return;
+
+    std::vector<unsigned int> hard(clusters);
+    if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+    hard.push_back(static_cast<unsigned int>(triCount));
+
+    // 在每个硬边界簇内，只要从簇起点累计的 ACMR 不超过 threshold × 整簇 ACMR 就切出一个软簇
+    std::vector<unsigned int> soft;
+    FifoCache cache(vertexCount, cacheSize);
+    for (size_t c = 0; c + 1 < hard.size(); ++c) {
+        const unsigned int begin = hard[c], end = hard[c + 1];
+        if (begin >= end) continue;
+        cache.reset();
+        unsigned misses = 0;
+        for (unsigned int t = begin; t < end; ++t) misses += missesForTriangle(cache, &indices[t * 3]);
+        const float limit = threshold * static_cast<float>(misses) / (end - begin);
+
+        cache.reset();
+        unsigned int start = begin;
+        unsigned running = 0;
+        soft.push_back(begin);
+        for (unsigned int t = begin; t < end; ++t) {
+            running += missesForTriangle(cache, &indices[t * 3]);
+            if (t + 1 < end && static_cast<float>(running) <= limit * (t + 1 - start)) {
+                soft.push_back(t + 1);
+                start = t + 1;
+                running = 0;
+                cache.reset();
+            }
+        }
+    }
+    soft.push_back(static_cast<unsigned int>(triCount));
+
+    // 网格中心（面积加权）
+    glm::dvec3 meshCenter(0.0);
+    double meshArea = 0.0;
+    std::vector<glm::vec3> triCenter(triCount), triCross(triCount);
+    for (size_t t = 0; t < triCount; ++t) {
+        glm::vec3 p0 = positionAt(vertices, stride, indices[t * 3]);
+        glm::vec3 p1 = positionAt(vertices, stride, indices[t * 3 + 1]);
+        glm::vec3 p2 = positionAt(vertices, stride, indices[t * 3 + 2]);
+        triCenter[t] = (p0 + p1 + p2) / 3.0f;
+        triCross[t] = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(triCross[t]);
+        meshCenter += glm::dvec3(triCenter[t]) * area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0) meshCenter /= meshArea;
+
+    // 簇排序键：簇中心相对网格中心在簇平均法线上的投影，越朝外越先绘制
+    const size_t clusterCount = soft.size() - 1;
+    std::vector<float> keys(clusterCount);
+    std::vector<unsigned int> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        glm::dvec3 center(0.0), normal(0.0);
+        double area = 0.0;
+        for (unsigned int t = soft[c]; t < soft[c + 1]; ++t) {
+            double a = glm::length(triCross[t]);
+            center += glm::dvec3(triCenter[t]) * a;
+            normal += glm::dvec3(triCross[t]);
+            area += a;
+        }
+        double len = glm::length(normal);
+        keys[c] = (area > 0.0 && len > 0.0)
+                      ? static_cast<float>(glm::dot(center / area - meshCenter, normal / len))
+                      : 0.0f;
+        order[c] = static_cast<unsigned int>(c);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    for (size_t i = 0; i < clusterCount; ++i) {
+        unsigned int c = order[i];
+        out.insert(out.end(), indices.begin() + soft[c] * 3, indices.begin() + soft[c + 1] * 3);
+    }
+    indices.swap(out);
+}
+
+void optimizeVertexFetch(Mesh& mesh) {
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<float> vertices;
+    vertices.reserve(mesh.vertices.size());
+    int next = 0;
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        unsigned int v = mesh.indices[i];
+        if (remap[v] < 0) {
+            remap[v] = next++;
+            vertices.insert(vertices.end(), mesh.vertices.begin() + v * 6, mesh.vertices.begin() + v * 6 + 6);
+        }
+        mesh.indices[i] = static_cast<unsigned int>(remap[v]);
+    }
+    mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(Mesh& mesh) {
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    if (mesh.indices.empty() || vertexCount == 0) return;
+
+    auto t0 = std::chrono::steady_clock::now();
+    VertexCacheStats before = analyzeVertexCache(mesh.indices, vertexCount);
+
+    std::vector<unsigned int> clusters;
+    optimizeVertexCache(mesh.indices, vertexCount, kVertexCacheSize, &clusters);
+    optimizeOverdraw(mesh.indices, clusters, mesh.vertices.data(), 6, vertexCount);
+    optimizeVertexFetch(mesh);
+
+    VertexCacheStats after = analyzeVertexCache(mesh.indices, static_cast<size_t>(mesh.vertexCount()));
+    std::cout << "Mesh optimize: ACMR " << before.acmr << " -> " << after.acmr
+              << ", ATVR " << before.atvr << " -> " << after.atvr
+              << " (" << kVertexCacheSize << "-entry FIFO), " << clusters.size() << " clusters, "
+              << elapsedMs(t0) << " ms" << std::endl;
+}
@@ -0,0 +1,320 @@
+#include "normals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "threadpool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NORMALS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX 内核通过函数级 target 属性编译，运行时检测 CPU 支持后启用
+#if defined(NORMALS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define NORMALS_AVX 1
+#include <immintrin.h>
+#define NORMALS_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace {
+
+const size_t kBatch = 8;          // SoA 批次宽度（AVX 8 路，SSE 两次 4 路）
+const size_t kTriBlock = 16384;   // 每个并行任务处理的三角形数
+const size_t kVertexBlock = 65536;
+const float kPi = 3.14159265358979f;
+const float kDegenerate = 1e-12f; // |cross| 低于此值视为退化三角形
+
+// Abramowitz & Stegun 4.4.46：acos(x) = sqrt(1 - x) * P(x)，0 <= x <= 1（float 运算下的误差见 normals.h）
+const float kAcos[8] = {
+    1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+    0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f,
+};
+
+// SoA 三角形批次：p[顶点][分量][通道]
+struct TriBatch {
+    float p[3][3][kBatch];
+};
+
+// 每个角点的加权法线：n[角点][分量][通道]
+struct CornerBatch {
+    float n[3][3][kBatch];
+};
+
+typedef void (*BatchKernel)(const TriBatch&, NormalWeighting, CornerBatch&);
+
+#ifndef NORMALS_SSE2
+
+inline float acosApprox(float x) {
+    float ax = std::fabs(x);
+    float p = kAcos[7];
+    for (int i = 6; i >= 0; --i) p = p * ax + kAcos[i];
+    float r = std::sqrt(1.0f - ax) * p;
+    return x < 0.0f ? kPi - r : r;
+}
+
+void kernelScalar(const TriBatch& b, NormalWeighting mode, CornerBatch& out) {
+    for (size_t l = 0; l < kBatch; ++l) {
+        glm::vec3 p0(b.p[0][0][l], b.p[0][1][l], b.p[0][2][l]);
+        glm::vec3 p1(b.p[1][0][l], b.p[1][1][l], b.p[1][2][l]);
+        glm::vec3 p2(b.p[2][0][l], b.p[2][1][l], b.p[2][2][l]);
+        glm::vec3 e0 = p1 - p0, e1 = p2 - p0, e2 = p2 - p1;
+        glm::vec3 c = glm::cross(e0, e1);
+        float len = glm::length(c);
+        glm::vec3 w(0.0f);
+        glm::vec3 fn(0.0f);
+        if (len >= kDegenerate) {
+            fn = c / len;
+            float l0 = glm::length(e0), l1 = glm::length(e1), l2 = glm::length(e2);
+            glm::vec3 a(acosApprox(glm::clamp(glm::dot(e0, e1) / (l0 * l1), -1.0f, 1.0f)),
+                        acosApprox(glm::clamp(-glm::dot(e0, e2) / (l0 * l2), -1.0f, 1.0f)),
+                        acosApprox(glm::clamp(glm::dot(e1, e2) / (l1 * l2), -1.0f, 1.0f)));
+            if (mode == NORMALS_AREA) w = glm::vec3(len);
+            else if (mode == NORMALS_ANGLE_AREA) w = a * len;
+            else w = a;
+        }
+        for (int k = 0; k < 3; ++k) {
+            out.n[k][0][l] = fn.x * w[k];
+            out.n[k][1][l] = fn.y * w[k];
+            out.n[k][2][l] = fn.z * w[k];
+        }
+    }
+}
+
+#else // NORMALS_SSE2
+
+inline __m128 acosSSE(__m128 x) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+    __m128 p = _mm_set1_ps(kAcos[7]);
+    for (int i = 6; i >= 0; --i) p = _mm_add_ps(_mm_mul_ps(p, ax), _mm_set1_ps(kAcos[i]));
+    __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), ax)), p);
+    __m128 neg = _mm_cmplt_ps(x, _mm_setzero_ps());
+    __m128 flipped = _mm_sub_ps(_mm_set1_ps(kPi), r);
+    return _mm_or_ps(_mm_and_ps(neg, flipped), _mm_andnot_ps(neg, r));
+}
+
+inline __m128 clampCos(__m128 x) {
+    return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+void kernelSSE(const TriBatch& b, NormalWeighting mode, CornerBatch& out) {
+    for (size_t l = 0; l < kBatch; l += 4) {
+        __m128 p0x = _mm_loadu_ps(&b.p[0][0][l]), p0y = _mm_loadu_ps(&b.p[0][1][l]), p0z = _mm_loadu_ps(&b.p[0][2][l]);
+        __m128 p1x = _mm_loadu_ps(&b.p[1][0][l]), p1y = _mm_loadu_ps(&b.p[1][1][l]), p1z = _mm_loadu_ps(&b.p[1][2][l]);
+        __m128 p2x = _mm_loadu_ps(&b.p[2][0][l]), p2y = _mm_loadu_ps(&b.p[2][1][l]), p2z = _mm_loadu_ps(&b.p[2][2][l]);
+
+        __m128 e0x = _mm_sub_ps(p1x, p0x), e0y = _mm_sub_ps(p1y, p0y), e0z = _mm_sub_ps(p1z, p0z);
+        __m128 e1x = _mm_sub_ps(p2x, p0x), e1y = _mm_sub_ps(p2y, p0y), e1z = _mm_sub_ps(p2z, p0z);
+        __m128 e2x = _mm_sub_ps(p2x, p1x), e2y = _mm_sub_ps(p2y, p1y), e2z = _mm_sub_ps(p2z, p1z);
+
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(e0y, e1z), _mm_mul_ps(e0z, e1y));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(e0z, e1x), _mm_mul_ps(e0x, e1z));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(e0x, e1y), _mm_mul_ps(e0y, e1x));
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+        __m128 valid = _mm_cmpge_ps(len, _mm_set1_ps(kDegenerate));
+        __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), len);
+        __m128 nx = _mm_mul_ps(cx, inv), ny = _mm_mul_ps(cy, inv), nz = _mm_mul_ps(cz, inv);
+
+        __m128 w[3];
+        if (mode == NORMALS_AREA) {
+            w[0] = w[1] = w[2] = len;
+        } else {
+            __m128 l0 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, e0x), _mm_mul_ps(e0y, e0y)), _mm_mul_ps(e0z, e0z)));
+            __m128 l1 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e1x), _mm_mul_ps(e1y, e1y)), _mm_mul_ps(e1z, e1z)));
+            __m128 l2 = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, e2x), _mm_mul_ps(e2y, e2y)), _mm_mul_ps(e2z, e2z)));
+            __m128 d01 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, e1x), _mm_mul_ps(e0y, e1y)), _mm_mul_ps(e0z, e1z));
+            __m128 d02 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, e2x), _mm_mul_ps(e0y, e2y)), _mm_mul_ps(e0z, e2z));
+            __m128 d12 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, e2x), _mm_mul_ps(e1y, e2y)), _mm_mul_ps(e1z, e2z));
+            w[0] = acosSSE(clampCos(_mm_div_ps(d01, _mm_mul_ps(l0, l1))));
+            w[1] = acosSSE(clampCos(_mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), d02), _mm_mul_ps(l0, l2))));
+            w[2] = acosSSE(clampCos(_mm_div_ps(d12, _mm_mul_ps(l1, l2))));
+            if (mode == NORMALS_ANGLE_AREA) {
+                for (int k = 0; k < 3; ++k) w[k] = _mm_mul_ps(w[k], len);
+            }
+        }
+        // 退化通道（含除零产生的 inf/nan）整体清零
+        for (int k = 0; k < 3; ++k) {
+            __m128 wk = _mm_and_ps(w[k], valid);
+            _mm_storeu_ps(&out.n[k][0][l], _mm_and_ps(_mm_mul_ps(nx, wk), valid));
+            _mm_storeu_ps(&out.n[k][1][l], _mm_and_ps(_mm_mul_ps(ny, wk), valid));
+            _mm_storeu_ps(&out.n[k][2][l], _mm_and_ps(_mm_mul_ps(nz, wk), valid));
+        }
+    }
+}
+
+#endif // NORMALS_SSE2
+
+#ifdef NORMALS_AVX
+
+NORMALS_TARGET_AVX inline __m256 acosAVX(__m256 x) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(signMask, x);
+    __m256 p = _mm256_set1_ps(kAcos[7]);
+    for (int i = 6; i >= 0; --i) p = _mm256_add_ps(_mm256_mul_ps(p, ax), _mm256_set1_ps(kAcos[i]));
+    __m256 r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), ax)), p);
+    __m256 neg = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(kPi), r), neg);
+}
+
+NORMALS_TARGET_AVX inline __m256 clampCosAVX(__m256 x) {
+    return _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+}
+
+NORMALS_TARGET_AVX inline __m256 dotAVX(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+}
+
+NORMALS_TARGET_AVX void kernelAVX(const TriBatch& b, NormalWeighting mode, CornerBatch& out) {
+    __m256 p0x = _mm256_loadu_ps(b.p[0][0]), p0y = _mm256_loadu_ps(b.p[0][1]), p0z = _mm256_loadu_ps(b.p[0][2]);
+    __m256 p1x = _mm256_loadu_ps(b.p[1][0]), p1y = _mm256_loadu_ps(b.p[1][1]), p1z = _mm256_loadu_ps(b.p[1][2]);
+    __m256 p2x = _mm256_loadu_ps(b.p[2][0]), p2y = _mm256_loadu_ps(b.p[2][1]), p2z = _mm256_loadu_ps(b.p[2][2]);
+
+    __m256 e0x = _mm256_sub_ps(p1x, p0x), e0y = _mm256_sub_ps(p1y, p0y), e0z = _mm256_sub_ps(p1z, p0z);
+    __m256 e1x = _mm256_sub_ps(p2x, p0x), e1y = _mm256_sub_ps(p2y, p0y), e1z = _mm256_sub_ps(p2z, p0z);
+    __m256 e2x = _mm256_sub_ps(p2x, p1x), e2y = _mm256_sub_ps(p2y, p1y), e2z = _mm256_sub_ps(p2z, p1z);
+
+    __m256 cx = _mm256_sub_ps(_mm256_mul_ps(e0y, e1z), _mm256_mul_ps(e0z, e1y));
+    __m256 cy = _mm256_sub_ps(_mm256_mul_ps(e0z, e1x), _mm256_mul_ps(e0x, e1z));
+    __m256 cz = _mm256_sub_ps(_mm256_mul_ps(e0x, e1y), _mm256_mul_ps(e0y, e1x));
+    __m256 len = _mm256_sqrt_ps(dotAVX(cx, cy, cz, cx, cy, cz));
+    __m256 valid = _mm256_cmp_ps(len, _mm256_set1_ps(kDegenerate), _CMP_GE_OQ);
+    __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), len);
+    __m256 nx = _mm256_mul_ps(cx, inv), ny = _mm256_mul_ps(cy, inv), nz = _mm256_mul_ps(cz, inv);
+
+    __m256 w[3];
+    if (mode == NORMALS_AREA) {
+        w[0] = w[1] = w[2] = len;
+    } else {
+        __m256 l0 = _mm256_sqrt_ps(dotAVX(e0x, e0y, e0z, e0x, e0y, e0z));
+        __m256 l1 = _mm256_sqrt_ps(dotAVX(e1x, e1y, e1z, e1x, e1y, e1z));
+        __m256 l2 = _mm256_sqrt_ps(dotAVX(e2x, e2y, e2z, e2x, e2y, e2z));
+        __m256 d01 = dotAVX(e0x, e0y, e0z, e1x, e1y, e1z);
+        __m256 d02 = dotAVX(e0x, e0y, e0z, e2x, e2y, e2z);
+        __m256 d12 = dotAVX(e1x, e1y, e1z, e2x, e2y, e2z);
+        w[0] = acosAVX(clampCosAVX(_mm256_div_ps(d01, _mm256_mul_ps(l0, l1))));
+        w[1] = acosAVX(clampCosAVX(_mm256_div_ps(_mm256_sub_ps(_mm256_setzero_ps(), d02), _mm256_mul_ps(l0, l2))));
+        w[2] = acosAVX(clampCosAVX(_mm256_div_ps(d12, _mm256_mul_ps(l1, l2))));
+        if (mode == NORMALS_ANGLE_AREA) {
+            for (int k = 0; k < 3; ++k) w[k] = _mm256_mul_ps(w[k], len);
+        }
+    }
+    for (int k = 0; k < 3; ++k) {
+        __m256 wk = _mm256_and_ps(w[k], valid);
+        _mm256_storeu_ps(out.n[k][0], _mm256_and_ps(_mm256_mul_ps(nx, wk), valid));
+        _mm256_storeu_ps(out.n[k][1], _mm256_and_ps(_mm256_mul_ps(ny, wk), valid));
+        _mm256_storeu_ps(out.n[k][2], _mm256_and_ps(_mm256_mul_ps(nz, wk), valid));
+    }
+}
+
+#endif // NORMALS_AVX
+
+BatchKernel selectKernel() {
+#ifdef NORMALS_AVX
+    if (__builtin_cpu_supports("avx")) return kernelAVX;
+#endif
+#ifdef NORMALS_SSE2
+    return kernelSSE;
+#else
+    return kernelScalar;
+#endif
+}
+
+// 计算 [triBegin, triEnd) 内每个角点的加权面法线
+void weightedCornerNormals(const std::vector<glm::vec3>& positions, const std::vector<ObjIndex>& corners,
+                           size_t triBegin, size_t triEnd, NormalWeighting mode, BatchKernel kernel,
+                           glm::vec3* cornerNormals) {
+    const int positionCount = static_cast<int>(positions.size());
+    TriBatch batch;
+    CornerBatch result;
+    for (size_t t = triBegin; t < triEnd; t += kBatch) {
+        size_t n = std::min(kBatch, triEnd - t);
+        // 收集为 SoA；越界三角形与补齐通道的顶点置零，按退化处理
+        for (size_t l = 0; l < kBatch; ++l) {
+            const ObjIndex *tri = (l < n) ? &corners[(t + l) * 3] : nullptr;
+            bool ok = tri != nullptr;
+            for (int k = 0; ok && k < 3; ++k) ok = tri[k].v >= 0 && tri[k].v < positionCount;
+            for (int k = 0; k < 3; ++k) {
+                glm::vec3 p = ok ? positions[tri[k].v] : glm::vec3(0.0f);
+                batch.p[k][0][l] = p.x;
+                batch.p[k][1][l] = p.y;
+                batch.p[k][2][l] = p.z;
+            }
+        }
+        kernel(batch, mode, result);
+        for (size_t l = 0; l < n; ++l) {
+            for (int k = 0; k < 3; ++k) {
+                cornerNormals[(t + l) * 3 + k] = glm::vec3(result.n[k][0][l], result.n[k][1][l], result.n[k][2][l]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool parseNormalWeighting(const std::string& name, NormalWeighting& out) {
+    if (name == "angle") out = NORMALS_ANGLE;
+    else if (name == "area") out = NORMALS_AREA;
+    else if (name == "angle-area") out = NORMALS_ANGLE_AREA;
+    else return false;
+    return true;
+}
+
+const char* normalWeightingName(NormalWeighting mode) {
+    switch (mode) {
+    case NORMALS_AREA: return "area";
+    case NORMALS_ANGLE_AREA: return "angle-area";
+    default: return "angle";
+    }
+}
+
+std::vector<glm::vec3> computeVertexNormals(const std::vector<glm::vec3>& positions,
+                                            const std::vector<ObjIndex>& corners,
+                                            NormalWeighting mode, unsigned threads) {
+    const size_t vertexCount = positions.size();
+    const size_t triCount = corners.size() / 3;
+    ThreadPool &pool = ThreadPool::shared();
+
+    // 1. 逐三角形并行：每个角点写入自己的槽位
+    std::vector<glm::vec3> cornerNormals(triCount * 3);
+    BatchKernel kernel = selectKernel();
+    size_t triBlocks = (triCount + kTriBlock - 1) / kTriBlock;
+    pool.parallelFor(triBlocks, [&](size_t b) {
+        size_t t0 = b * kTriBlock;
+        size_t t1 = std::min(triCount, t0 + kTriBlock);
+        weightedCornerNormals(positions, corners, t0, t1, mode, kernel, cornerNormals.data());
+    }, threads);
+
+    // 2. 顶点 → 角点表（计数排序，角点按原顺序排列，保证累加顺序与串行一致）
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t c = 0; c < triCount * 3; ++c) {
+        int v = corners[c].v;
+        if (v >= 0 && static_cast<size_t>(v) < vertexCount) ++offsets[v + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> vertexCorners(offsets[vertexCount]);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t c = 0; c < triCount * 3; ++c) {
+            int v = corners[c].v;
+            if (v >= 0 && static_cast<size_t>(v) < vertexCount) vertexCorners[cursor[v]++] = static_cast<uint32_t>(c);
+        }
+    }
+
+    // 3. 逐顶点并行汇总并归一化
+    std::vector<glm::vec3> normals(vertexCount, glm::vec3(0.0f));
+    size_t vertexBlocks = (vertexCount + kVertexBlock - 1) / kVertexBlock;
+    pool.parallelFor(vertexBlocks, [&](size_t b) {
+        size_t v0 = b * kVertexBlock;
+        size_t v1 = std::min(vertexCount, v0 + kVertexBlock);
+        for (size_t v = v0; v < v1; ++v) {
+            glm::vec3 n(0.0f);
+            for (uint32_t i = offsets[v]; i < offsets[v + 1]; ++i) n += cornerNormals[vertexCorners[i]];
+            float len = glm::length(n);
+            if (len > 1e-8f) n /= len;
+            normals[v] = n;
+        }
+    }, threads);
+    return normals;
+}
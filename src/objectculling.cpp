@@ -0,0 +1,79 @@
+#include "objectculling.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "threadpool.h"
+
+ObjectCuller::ObjectCuller() : center_(0.0f), extent_(0.0f), occlusionStats_() {}
+
+void ObjectCuller::setBounds(const glm::vec3& center, const glm::vec3& extent) {
+    center_ = center;
+    extent_ = extent;
+}
+
+bool ObjectCuller::setOccluder(const MeshBuffers& mb) {
+    if (extractOccluder(mb, kMaxOccluderTriangles, occluder_)) return true;
+    occluder_ = OccluderMesh();
+    return false;
+}
+
+unsigned ObjectCuller::cull(const glm::mat4& viewProj, const glm::vec3& camera, const glm::mat4* models,
+                            size_t count, FrustumCullTotals* stats) {
+    auto c0 = std::chrono::steady_clock::now();
+    transformBox(center_, extent_, models, count, boxes_);
+    visible_.resize(count);
+    unsigned visible = Frustum::fromMatrix(viewProj).cullBoxes(boxes_, visible_.data());
+    if (stats) {
+        stats->objectsVisible += visible;
+        stats->objectsCulled += static_cast<unsigned>(count) - visible;
+        stats->ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - c0).count();
+    }
+    if (!occluder_.empty() && count > 1) visible -= cullOccluded(viewProj, camera, models, count, visible, stats != NULL);
+    return visible;
+}
+
+unsigned ObjectCuller::cullOccluded(const glm::mat4& viewProj, const glm::vec3& camera, const glm::mat4* models,
+                                    size_t count, unsigned tested, bool record) {
+    // 由近到远取前 kMaxOccluders 个视锥内物体作为遮挡体
+    auto o0 = std::chrono::steady_clock::now();
+    occluderOrder_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (!visible_[i]) continue;
+        glm::vec3 center(boxes_.x[i], boxes_.y[i], boxes_.z[i]);
+        occluderOrder_.push_back(std::make_pair(glm::length(center - camera), static_cast<uint32_t>(i)));
+    }
+    size_t occluders = std::min(occluderOrder_.size(), kMaxOccluders);
+    std::partial_sort(occluderOrder_.begin(), occluderOrder_.begin() + occluders, occluderOrder_.end());
+    occluderMVPs_.resize(occluders);
+    for (size_t k = 0; k < occluders; ++k) occluderMVPs_[k] = viewProj * models[occluderOrder_[k].second];
+    occlusion_.render(occluder_, occluderMVPs_.data(), occluders, ThreadPool::shared());
+    auto o1 = std::chrono::steady_clock::now();
+    // 遮挡体自身也参与测试：其 AABB 的最近深度不大于自身表面，不会被自己遮挡
+    unsigned occluded = occlusion_.cullBoxes(boxes_, viewProj, visible_.data());
+    auto o2 = std::chrono::steady_clock::now();
+    if (record) {
+        occlusionStats_.occluded += occluded;
+        occlusionStats_.tested += tested;
+        occlusionStats_.occluders += static_cast<unsigned>(occluders);
+        occlusionStats_.triangles += occlusion_.trianglesRasterized();
+        occlusionStats_.rasterMs += std::chrono::duration<double, std::milli>(o1 - o0).count();
+        occlusionStats_.testMs += std::chrono::duration<double, std::milli>(o2 - o1).count();
+        ++occlusionStats_.frames;
+    }
+    return occluded;
+}
+
+void ObjectCuller::compact(const InstanceArrays& instances, InstanceArrays& out) const {
+    size_t count = 0;
+    for (size_t i = 0; i < visible_.size(); ++i) count += visible_[i] ? 1 : 0;
+    out.resize(count);
+    size_t v = 0;
+    for (size_t i = 0; i < visible_.size() && i < instances.size(); ++i) {
+        if (!visible_[i]) continue;
+        out.model[v] = instances.model[i];
+        out.normal[v] = instances.normal[i];
+        out.material[v] = instances.material[i];
+        ++v;
+    }
+}
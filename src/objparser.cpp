@@ -0,0 +1,350 @@
+#include "objparser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "mappedfile.h"
+#include "threadpool.h"
+
+namespace {
+
+// 并行解析时每块的最小字节数，过小的块拼接开销得不偿失
+const size_t kMinChunkBytes = 1 << 20;
+
+// 10^0 .. 10^22 均可被 double 精确表示
+const double kPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool isDigit(char c) { return static_cast<unsigned>(c - '0') < 10u; }
+
+inline const char* skipBlank(const char* p, const char* e) {
+    while (p < e && isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char* skipToken(const char* p, const char* e) {
+    while (p < e && !isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char* lineEnd(const char* p, const char* e) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(e - p)));
+    return eol ? eol : e;
+}
+
+// 与 locale 无关的浮点解析：最多取 19 位有效数字，指数在 ±22 内时结果与
+// 正确舍入的 double 一致，再转为 float
+const char* parseFloat(const char* p, const char* e, float& out) {
+    p = skipBlank(p, e);
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mant = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool any = false;
+    while (p < e && isDigit(*p)) {
+        any = true;
+        if (digits < 19) {
+            mant = mant * 10 + static_cast<unsigned>(*p - '0');
+            if (mant) ++digits;
+        } else {
+            ++exp10;
+        }
+        ++p;
+    }
+    if (p < e && *p == '.') {
+        ++p;
+        while (p < e && isDigit(*p)) {
+            any = true;
+            if (digits < 19) {
+                mant = mant * 10 + static_cast<unsigned>(*p - '0');
+                if (mant) ++digits;
+                --exp10;
+            }
+            ++p;
+        }
+    }
+    if (!any) {
+        // inf / nan 等非数字记号：跳过并按 0 处理
+        out = 0.0f;
+        return skipToken(p, e);
+    }
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool eneg = false;
+        if (q < e && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            ++q;
+        }
+        if (q < e && isDigit(*q)) {
+            int ev = 0;
+            while (q < e && isDigit(*q)) {
+                if (ev < 10000) ev = ev * 10 + (*q - '0');
+                ++q;
+            }
+            exp10 += eneg ? -ev : ev;
+            p = q;
+        }
+    }
+
+    double d = static_cast<double>(mant);
+    if (mant != 0) {
+        if (exp10 < 0 && exp10 >= -22) d /= kPow10[-exp10];
+        else if (exp10 >= 0 && exp10 <= 22) d *= kPow10[exp10];
+        else d *= std::pow(10.0, exp10);
+    }
+    out = static_cast<float>(neg ? -d : d);
+    return p;
+}
+
+// 解析带符号整数，没有数字时 out = 0
+const char* parseInt(const char* p, const char* e, int& out) {
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+    long long v = 0;
+    while (p < e && isDigit(*p)) {
+        if (v < 0x7fffffffLL) v = v * 10 + (*p - '0');
+        ++p;
+    }
+    if (v > 0x7fffffffLL) v = 0x7fffffffLL;
+    out = static_cast<int>(neg ? -v : v);
+    return p;
+}
+
+// 1 基 / 负数相对索引 → 0 基绝对索引；0（缺省）→ -1
+inline int resolveIndex(int idx, size_t count) {
+    if (idx > 0) return idx - 1;
+    if (idx < 0) return static_cast<int>(count) + idx;
+    return -1;
+}
+
+void parseFace(const char* p, const char* e, ObjData& out, ObjRelativeRefs* rel) {
+    ObjIndex face[4];
+    unsigned relV = 0, relN = 0; // 第 i 个记号使用相对索引时置位
+    int count = 0;
+    for (;;) {
+        p = skipBlank(p, e);
+        if (p >= e) break;
+        // 解析 v | v/t | v//n | v/t/n
+        int v = 0, t = 0, n = 0;
+        p = parseInt(p, e, v);
+        if (p < e && *p == '/') {
+            ++p;
+            if (p < e && *p == '/') {
+                ++p;
+                p = parseInt(p, e, n);
+            } else {
+                p = parseInt(p, e, t);
+                if (p < e && *p == '/') {
+                    ++p;
+                    p = parseInt(p, e, n);
+                }
+            }
+        }
+        p = skipToken(p, e);
+        if (count < 4) {
+            face[count].v = resolveIndex(v, out.positions.size());
+            face[count].n = resolveIndex(n, out.normals.size());
+            if (v < 0) relV |= 1u << count;
+            if (n < 0) relN |= 1u << count;
+        }
+        ++count;
+    }
+    // 三角或四边形，四边形拆分为两个三角形: 0-1-2, 0-2-3
+    static const int kTri[3] = {0, 1, 2};
+    static const int kQuad[6] = {0, 1, 2, 0, 2, 3};
+    const int *order = nullptr;
+    int emit = 0;
+    if (count == 3) {
+        order = kTri;
+        emit = 3;
+    } else if (count == 4) {
+        order = kQuad;
+        emit = 6;
+    }
+    for (int i = 0; i < emit; ++i) {
+        int k = order[i];
+        if (rel && (relV >> k & 1u)) rel->v.push_back(out.corners.size());
+        if (rel && (relN >> k & 1u)) rel->n.push_back(out.corners.size());
+        out.corners.push_back(face[k]);
+    }
+}
+
+// 在 [p, e) 内查找 key，返回其后 '=' 右侧的整数，找不到返回 0
+size_t hintValue(const char* p, const char* e, const char* key) {
+    size_t klen = strlen(key);
+    for (; p + klen <= e; ++p) {
+        if (memcmp(p, key, klen) != 0) continue;
+        const char* q = p + klen;
+        q = skipBlank(q, e);
+        if (q >= e || *q != '=') return 0;
+        q = skipBlank(q + 1, e);
+        int v = 0;
+        parseInt(q, e, v);
+        return v > 0 ? static_cast<size_t>(v) : 0;
+    }
+    return 0;
+}
+
+} // namespace
+
+ObjRecordCount scanOBJHeaderHints(const char* begin, const char* end) {
+    ObjRecordCount hint = {0, 0, 0};
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        const char* q = skipBlank(p, eol);
+        if (q < eol && *q != '#') break; // 头部注释结束
+        if (q < eol) {
+            if (!hint.positions) hint.positions = hintValue(q, eol, "vertex count");
+            if (!hint.faces) hint.faces = hintValue(q, eol, "face count");
+        }
+        p = eol + 1;
+    }
+    return hint;
+}
+
+ObjRecordCount countOBJRecords(const char* begin, const char* end) {
+    ObjRecordCount count = {0, 0, 0};
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        const char* q = skipBlank(p, eol);
+        if (q + 1 < eol) {
+            if (q[0] == 'v') {
+                if (isBlank(q[1])) ++count.positions;
+                else if (q[1] == 'n') ++count.normals;
+            } else if (q[0] == 'f' && isBlank(q[1])) {
+                ++count.faces;
+            }
+        }
+        p = eol + 1;
+    }
+    return count;
+}
+
+void parseOBJRange(const char* begin, const char* end, ObjData& out, ObjRelativeRefs* rel) {
+    const char* p = begin;
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        const char* q = skipBlank(p, eol);
+        if (q + 1 < eol) {
+            if (q[0] == 'v' && isBlank(q[1])) {
+                // 读取顶点坐标
+                glm::vec3 v(0.0f);
+                q = parseFloat(q + 1, eol, v.x);
+                q = parseFloat(q, eol, v.y);
+                parseFloat(q, eol, v.z);
+                out.positions.push_back(v);
+            } else if (q[0] == 'v' && q[1] == 'n' && (q + 2 == eol || isBlank(q[2]))) {
+                glm::vec3 n(0.0f);
+                q = parseFloat(q + 2, eol, n.x);
+                q = parseFloat(q, eol, n.y);
+                parseFloat(q, eol, n.z);
+                out.normals.push_back(n);
+            } else if (q[0] == 'f' && isBlank(q[1])) {
+                parseFace(q + 1, eol, out, rel);
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+void parseOBJParallel(const char* begin, const char* end, ObjData& out, unsigned threads) {
+    ThreadPool &pool = ThreadPool::shared();
+    if (threads == 0) threads = pool.size();
+    size_t bytes = static_cast<size_t>(end - begin);
+    // 每块至少 kMinChunkBytes，块数取线程数的数倍以平衡负载
+    size_t chunkCount = std::min<size_t>(static_cast<size_t>(threads) * 4, bytes / kMinChunkBytes);
+    if (threads <= 1 || chunkCount <= 1) {
+        parseOBJRange(begin, end, out);
+        return;
+    }
+
+    // 按换行对齐的分块边界
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds[0] = begin;
+    bounds[chunkCount] = end;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* p = begin + bytes / chunkCount * i;
+        if (p < bounds[i - 1]) p = bounds[i - 1];
+        p = lineEnd(p, end);
+        bounds[i] = (p < end) ? p + 1 : end;
+    }
+
+    std::vector<ObjData> chunks(chunkCount);
+    std::vector<ObjRelativeRefs> rels(chunkCount);
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        parseOBJRange(bounds[i], bounds[i + 1], chunks[i], &rels[i]);
+    }, threads);
+
+    // 前缀和：每块在全局数组中的起始位置
+    std::vector<size_t> posBase(chunkCount), nrmBase(chunkCount), cornerBase(chunkCount);
+    size_t posTotal = out.positions.size();
+    size_t nrmTotal = out.normals.size();
+    size_t cornerTotal = out.corners.size();
+    for (size_t i = 0; i < chunkCount; ++i) {
+        posBase[i] = posTotal;
+        nrmBase[i] = nrmTotal;
+        cornerBase[i] = cornerTotal;
+        posTotal += chunks[i].positions.size();
+        nrmTotal += chunks[i].normals.size();
+        cornerTotal += chunks[i].corners.size();
+    }
+    out.positions.resize(posTotal);
+    out.normals.resize(nrmTotal);
+    out.corners.resize(cornerTotal);
+
+    // 并行拷贝到全局数组，并把相对索引重定位到全局计数
+    pool.parallelFor(chunkCount, [&](size_t i) {
+        ObjData &c = chunks[i];
+        std::copy(c.positions.begin(), c.positions.end(), out.positions.begin() + posBase[i]);
+        std::copy(c.normals.begin(), c.normals.end(), out.normals.begin() + nrmBase[i]);
+        ObjIndex *dst = out.corners.data() + cornerBase[i];
+        std::copy(c.corners.begin(), c.corners.end(), dst);
+        const int pb = static_cast<int>(posBase[i]);
+        const int nb = static_cast<int>(nrmBase[i]);
+        for (size_t k : rels[i].v) dst[k].v += pb;
+        for (size_t k : rels[i].n) dst[k].n += nb;
+        // 尽早释放分块内存
+        std::vector<glm::vec3>().swap(c.positions);
+        std::vector<glm::vec3>().swap(c.normals);
+        std::vector<ObjIndex>().swap(c.corners);
+    }, threads);
+}
+
+bool parseOBJFile(const std::string& filename, ObjData& out, size_t& bytes, unsigned threads) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+    bytes = file.size();
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    if (threads == 0) threads = ThreadPool::shared().size();
+    if (threads > 1 && bytes >= kMinChunkBytes * 2) {
+        parseOBJParallel(begin, end, out, threads);
+        return true;
+    }
+
+    // 预分配：优先使用头部提示，否则先扫描一遍计数
+    ObjRecordCount count = scanOBJHeaderHints(begin, end);
+    if (!count.positions || !count.faces) count = countOBJRecords(begin, end);
+    out.positions.reserve(out.positions.size() + count.positions);
+    out.normals.reserve(out.normals.size() + count.normals);
+    out.corners.reserve(out.corners.size() + count.faces * 3);
+
+    parseOBJRange(begin, end, out);
+    return true;
+}
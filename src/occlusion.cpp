@@ -0,0 +1,297 @@
+#include "occlusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "threadpool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#else
+#define OCCLUSION_SSE2 0
+#endif
+
+namespace {
+
+uint32_t readIndex(const MeshBuffers& mb, size_t i) {
+    if (mb.indexSize == 2) return static_cast<const uint16_t*>(mb.indexData)[i];
+    return static_cast<const uint32_t*>(mb.indexData)[i];
+}
+
+glm::vec3 readPosition(const MeshBuffers& mb, uint32_t vertex) {
+    const VertexAttrib &a = mb.layout.attribs[0];
+    const unsigned char *p = static_cast<const unsigned char*>(mb.vertexData) +
+                             static_cast<size_t>(vertex) * mb.layout.stride + a.offset;
+    glm::vec3 v(0.0f);
+    if (a.type == ATTRIB_UNORM16) {
+        uint16_t q[3];
+        memcpy(q, p, sizeof(q));
+        v = glm::vec3(q[0], q[1], q[2]) / 65535.0f;
+    } else {
+        memcpy(&v[0], p, sizeof(float) * 3);
+    }
+    return mb.positionOffset + mb.positionScale * v;
+}
+
+}
+
+bool extractOccluder(const MeshBuffers& mb, unsigned maxTriangles, OccluderMesh& out) {
+    out.positions.clear();
+    out.indices.clear();
+    if (!mb.vertexData || mb.layout.attribCount == 0) return false;
+    const VertexAttrib &pos = mb.layout.attribs[0];
+    if (pos.components < 3 || (pos.type != ATTRIB_FLOAT32 && pos.type != ATTRIB_UNORM16)) return false;
+
+    // 索引范围 [first, first + count)；无索引时按顶点顺序每 3 个一个三角形
+    size_t first = 0, count = 0;
+    bool found = false;
+    if (mb.indexData) {
+        for (unsigned l = 0; l < mb.lodCount && !found; ++l) {
+            if (mb.lods[l].indexCount / 3 > maxTriangles) continue;
+            first = mb.lods[l].indexOffset;
+            count = mb.lods[l].indexCount;
+            found = true;
+        }
+        // 都超出上限时仍用最粗一级（已简化）
+        if (!found && mb.lodCount > 1) {
+            first = mb.lods[mb.lodCount - 1].indexOffset;
+            count = mb.lods[mb.lodCount - 1].indexCount;
+            found = true;
+        }
+        if (!found && mb.lodCount == 0 && mb.indexCount / 3 <= maxTriangles) {
+            count = mb.indexCount;
+            found = true;
+        }
+    } else if (mb.vertexCount / 3 <= maxTriangles) {
+        count = mb.vertexCount;
+        found = true;
+    }
+    if (!found || count < 3) return false;
+
+    std::vector<uint32_t> remap(mb.vertexCount, ~0u);
+    out.indices.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t v = mb.indexData ? readIndex(mb, first + i) : static_cast<uint32_t>(i);
+        if (remap[v] == ~0u) {
+            remap[v] = static_cast<uint32_t>(out.positions.size());
+            out.positions.push_back(readPosition(mb, v));
+        }
+        out.indices.push_back(remap[v]);
+    }
+    return true;
+}
+
+OcclusionBuffer::OcclusionBuffer()
+    : depth_(kWidth * kHeight, 1.0f), blocks_((kWidth / kBlockSize) * (kHeight / kBlockSize), 1.0f), rasterized_(0) {
+}
+
+void OcclusionBuffer::render(const OccluderMesh& mesh, const glm::mat4* mvps, size_t count, ThreadPool& pool) {
+    const size_t vertexCount = mesh.positions.size();
+    const size_t triangleCount = mesh.triangleCount();
+    clip_.resize(vertexCount * count);
+    triangles_.resize(triangleCount * count);
+    accepted_.resize(triangleCount * count);
+
+    // 逐实例变换与三角形建立：实例间互不相关，按实例并行
+    pool.parallelFor(count, [&](size_t instance) {
+        const glm::mat4 &m = mvps[instance];
+        glm::vec4 *clip = &clip_[instance * vertexCount];
+        for (size_t v = 0; v < vertexCount; ++v) clip[v] = m * glm::vec4(mesh.positions[v], 1.0f);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            ScreenTriangle &tri = triangles_[instance * triangleCount + t];
+            uint8_t &ok = accepted_[instance * triangleCount + t];
+            ok = 0;
+            float z[3];
+            bool nearClipped = false;
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec4 &c = clip[mesh.indices[t * 3 + k]];
+                // 与近平面相交的三角形不裁剪，直接丢弃（少遮挡只影响剔除率，不影响正确性）
+                if (c.z < -c.w || c.w <= 0.0f) {
+                    nearClipped = true;
+                    break;
+                }
+                float inv = 1.0f / c.w;
+                tri.x[k] = (c.x * inv * 0.5f + 0.5f) * kWidth;
+                tri.y[k] = (c.y * inv * 0.5f + 0.5f) * kHeight;
+                z[k] = c.z * inv * 0.5f + 0.5f;
+            }
+            if (nearClipped) continue;
+            float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+            if (std::fabs(area) < 1e-6f) continue;
+            // 双面光栅化：统一为逆时针，使三条边函数在内部均非负
+            if (area < 0.0f) {
+                std::swap(tri.x[1], tri.x[2]);
+                std::swap(tri.y[1], tri.y[2]);
+                std::swap(z[1], z[2]);
+                area = -area;
+            }
+            float dx1 = tri.x[1] - tri.x[0], dy1 = tri.y[1] - tri.y[0];
+            float dx2 = tri.x[2] - tri.x[0], dy2 = tri.y[2] - tri.y[0];
+            tri.dzdx = ((z[1] - z[0]) * dy2 - dy1 * (z[2] - z[0])) / area;
+            tri.dzdy = (dx1 * (z[2] - z[0]) - (z[1] - z[0]) * dx2) / area;
+            tri.z0 = z[0] - tri.dzdx * tri.x[0] - tri.dzdy * tri.y[0];
+            // 覆盖像素中心 (px + 0.5, py + 0.5) 的范围
+            float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+            float maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+            float minY = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+            float maxY = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+            tri.minX = std::max(static_cast<int>(std::ceil(minX - 0.5f)), 0);
+            tri.maxX = std::min(static_cast<int>(std::floor(maxX - 0.5f)), kWidth - 1);
+            tri.minY = std::max(static_cast<int>(std::ceil(minY - 0.5f)), 0);
+            tri.maxY = std::min(static_cast<int>(std::floor(maxY - 0.5f)), kHeight - 1);
+            if (tri.minX > tri.maxX || tri.minY > tri.maxY) continue;
+            if (std::min(z[0], std::min(z[1], z[2])) >= 1.0f) continue;
+            ok = 1;
+        }
+    });
+    rasterized_ = 0;
+    for (size_t i = 0; i < accepted_.size(); ++i) rasterized_ += accepted_[i];
+
+    // 各条带只写自己的行，无需同步
+    pool.parallelFor(kBands, [&](size_t band) {
+        rasterizeBand(static_cast<int>(band));
+        buildBlocks(static_cast<int>(band));
+    });
+}
+
+void OcclusionBuffer::rasterizeBand(int band) {
+    const int rows = kHeight / kBands;
+    const int y0 = band * rows, y1 = y0 + rows - 1;
+    std::fill(depth_.begin() + y0 * kWidth, depth_.begin() + (y1 + 1) * kWidth, 1.0f);
+
+    for (size_t t = 0; t < triangles_.size(); ++t) {
+        if (!accepted_[t]) continue;
+        const ScreenTriangle &tri = triangles_[t];
+        if (tri.maxY < y0 || tri.minY > y1) continue;
+        // 边 a->b 的边函数 E = A * x + B * y + C，在三角形内部非负
+        float A[3], B[3], C[3];
+        for (int e = 0; e < 3; ++e) {
+            int a = e, b = (e + 1) % 3;
+            A[e] = tri.y[a] - tri.y[b];
+            B[e] = tri.x[b] - tri.x[a];
+            C[e] = -(A[e] * tri.x[a] + B[e] * tri.y[a]);
+        }
+        const int rowBegin = std::max(tri.minY, y0), rowEnd = std::min(tri.maxY, y1);
+        const int xBegin = tri.minX & ~3;
+#if OCCLUSION_SSE2
+        const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 a0 = _mm_set1_ps(A[0]), a1 = _mm_set1_ps(A[1]), a2 = _mm_set1_ps(A[2]);
+        const __m128 dz = _mm_set1_ps(tri.dzdx);
+        const __m128 zero = _mm_setzero_ps();
+        for (int y = rowBegin; y <= rowEnd; ++y) {
+            const float py = y + 0.5f;
+            const __m128 r0 = _mm_set1_ps(B[0] * py + C[0]);
+            const __m128 r1 = _mm_set1_ps(B[1] * py + C[1]);
+            const __m128 r2 = _mm_set1_ps(B[2] * py + C[2]);
+            const __m128 rz = _mm_set1_ps(tri.z0 + tri.dzdy * py);
+            float *row = &depth_[y * kWidth];
+            for (int x = xBegin; x <= tri.maxX; x += 4) {
+                __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), r0), zero),
+                                           _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), r1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), r2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                __m128 current = _mm_loadu_ps(row + x);
+                __m128 z = _mm_min_ps(current, _mm_add_ps(_mm_mul_ps(dz, px), rz));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, z), _mm_andnot_ps(inside, current)));
+            }
+        }
+#else
+        for (int y = rowBegin; y <= rowEnd; ++y) {
+            const float py = y + 0.5f;
+            float *row = &depth_[y * kWidth];
+            for (int x = xBegin; x <= tri.maxX; ++x) {
+                const float px = x + 0.5f;
+                if (A[0] * px + B[0] * py + C[0] < 0.0f || A[1] * px + B[1] * py + C[1] < 0.0f ||
+                    A[2] * px + B[2] * py + C[2] < 0.0f) continue;
+                row[x] = std::min(row[x], tri.z0 + tri.dzdx * px + tri.dzdy * py);
+            }
+        }
+#endif
+    }
+}
+
+void OcclusionBuffer::buildBlocks(int band) {
+    const int rows = kHeight / kBands;
+    const int blocksX = kWidth / kBlockSize;
+    for (int by = band * rows / kBlockSize; by < (band + 1) * rows / kBlockSize; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            float farthest = 0.0f;
+            for (int y = by * kBlockSize; y < (by + 1) * kBlockSize; ++y) {
+                const float *row = &depth_[y * kWidth + bx * kBlockSize];
+                for (int x = 0; x < kBlockSize; ++x) farthest = std::max(farthest, row[x]);
+            }
+            blocks_[by * blocksX + bx] = farthest;
+        }
+    }
+}
+
+bool OcclusionBuffer::projectBox(const glm::vec3& center, const glm::vec3& extent, const glm::mat4& viewProj,
+                                 OccludeeRect& rect) {
+    float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, minZ = 1e30f;
+    for (int k = 0; k < 8; ++k) {
+        glm::vec3 corner = center + glm::vec3((k & 1) ? extent.x : -extent.x, (k & 2) ? extent.y : -extent.y,
+                                              (k & 4) ? extent.z : -extent.z);
+        glm::vec4 c = viewProj * glm::vec4(corner, 1.0f);
+        if (c.z < -c.w || c.w <= 0.0f) return false;
+        float inv = 1.0f / c.w;
+        float x = (c.x * inv * 0.5f + 0.5f) * kWidth;
+        float y = (c.y * inv * 0.5f + 0.5f) * kHeight;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, c.z * inv * 0.5f + 0.5f);
+    }
+    // 矩形触及的像素再向外扩一圈：遮挡体只在像素中心采样，轮廓处部分覆盖的像素不能算作整个被遮住
+    rect.x0 = std::max(static_cast<int>(std::floor(minX)) - 1, 0);
+    rect.x1 = std::min(static_cast<int>(std::floor(maxX)) + 1, kWidth - 1);
+    rect.y0 = std::max(static_cast<int>(std::floor(minY)) - 1, 0);
+    rect.y1 = std::min(static_cast<int>(std::floor(maxY)) + 1, kHeight - 1);
+    rect.depth = minZ;
+    return rect.x0 <= rect.x1 && rect.y0 <= rect.y1;
+}
+
+bool OcclusionBuffer::occluded(const OccludeeRect& rect) const {
+    const int blocksX = kWidth / kBlockSize;
+    for (int by = rect.y0 / kBlockSize; by <= rect.y1 / kBlockSize; ++by) {
+        for (int bx = rect.x0 / kBlockSize; bx <= rect.x1 / kBlockSize; ++bx) {
+            // 块内最远深度已比物体近：整块遮挡，无需逐像素
+            if (blocks_[by * blocksX + bx] < rect.depth) continue;
+            int x0 = std::max(rect.x0, bx * kBlockSize), x1 = std::min(rect.x1, (bx + 1) * kBlockSize - 1);
+            int y0 = std::max(rect.y0, by * kBlockSize), y1 = std::min(rect.y1, (by + 1) * kBlockSize - 1);
+            for (int y = y0; y <= y1; ++y) {
+                const float *row = &depth_[y * kWidth];
+                for (int x = x0; x <= x1; ++x) {
+                    if (row[x] >= rect.depth) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+unsigned OcclusionBuffer::cullBoxes(const BoxArrays& boxes, const glm::mat4& viewProj, uint8_t* visible) const {
+    unsigned count = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        if (!visible[i]) continue;
+        OccludeeRect rect;
+        glm::vec3 center(boxes.x[i], boxes.y[i], boxes.z[i]);
+        glm::vec3 extent(boxes.ex[i], boxes.ey[i], boxes.ez[i]);
+        if (!projectBox(center, extent, viewProj, rect) || !occluded(rect)) continue;
+        visible[i] = 0;
+        ++count;
+    }
+    return count;
+}
+
+void OcclusionTotals::report(std::ostream& out) const {
+    if (!frames) return;
+    const float f = static_cast<float>(frames);
+    out << "Occlusion: objects " << occluded / f << " occluded / " << tested / f << " tested, " << occluders / f
+        << " occluders (" << triangles / f << " triangles), raster " << rasterMs / f << " ms, test " << testMs / f
+        << " ms per frame over " << frames << " frames" << std::endl;
+}
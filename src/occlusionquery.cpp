@@ -0,0 +1,166 @@
+#include "occlusionquery.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "glextensions.h"
+#include "glstate.h"
+
+void OcclusionQueryStats::report(std::ostream& out) const {
+    if (!frames) return;
+    const float f = static_cast<float>(frames);
+    out << "Occlusion queries: " << issued / f << " issued, " << results / f << " results, draws skipped "
+        << skipped / f << " on CPU + " << conditionalSkipped / f << " by conditional rendering (of "
+        << conditional / f << " conditional) per frame over " << frames << " frames" << std::endl;
+}
+
+OcclusionQueries::OcclusionQueries()
+    : vao_(0), vbo_(0), ebo_(0), boundsMin_(0.0f), boundsMax_(0.0f), frame_(0), stats_() {}
+
+OcclusionQueries::~OcclusionQueries() {
+    for (size_t i = 0; i < objects_.size(); ++i) glDeleteQueries(1, &objects_[i].query);
+    glState().deleteVertexArray(vao_);
+    glState().deleteBuffer(vbo_);
+    glState().deleteBuffer(ebo_);
+}
+
+bool OcclusionQueries::create(const std::string& shaderDir, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                              size_t objectCount) {
+    shader_.compile(shaderDir + "bounds-vertex.vs", shaderDir + "bounds-fragment.fs");
+    if (!shader_.finish()) return false;
+    mvpUniform_ = shader_.uniform<glm::mat4>("uMVP");
+
+    // 包围盒略放大：与模型表面重合时（如立方体）不被模型自身的深度挡住
+    const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    const glm::vec3 half = 0.505f * (boundsMax - boundsMin) + 0.001f * glm::length(boundsMax - boundsMin);
+    boundsMin_ = center - half;
+    boundsMax_ = center + half;
+    float corners[8 * 3];
+    for (int i = 0; i < 8; ++i) {
+        corners[i * 3 + 0] = (i & 1) ? boundsMax_.x : boundsMin_.x;
+        corners[i * 3 + 1] = (i & 2) ? boundsMax_.y : boundsMin_.y;
+        corners[i * 3 + 2] = (i & 4) ? boundsMax_.z : boundsMin_.z;
+    }
+    // 六个面各两个三角形（角点下标的位 0/1/2 分别对应 x/y/z 取最大值）
+    const GLushort faces[6][4] = {{0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}};
+    GLushort indices[36];
+    for (int f = 0; f < 6; ++f) {
+        const GLushort tri[6] = {faces[f][0], faces[f][1], faces[f][2], faces[f][0], faces[f][2], faces[f][3]};
+        std::copy(tri, tri + 6, indices + f * 6);
+    }
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ebo_);
+    glState().bindVertexArray(vao_);
+    glState().bindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glState().bindVertexArray(0);
+    glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    objects_.resize(objectCount);
+    for (size_t i = 0; i < objectCount; ++i) {
+        ObjectState &s = objects_[i];
+        glGenQueries(1, &s.query);
+        s.candidate = s.pending = s.valid = false;
+        s.visible = true;
+        s.nextQuery = 0;
+        s.conditionalDraws = 0;
+    }
+    return true;
+}
+
+void OcclusionQueries::beginFrame() {
+    ++frame_;
+    ++stats_.frames;
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        ObjectState &s = objects_[i];
+        if (!s.pending) continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(s.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint passed = 0;
+        glGetQueryObjectuiv(s.query, GL_QUERY_RESULT, &passed);
+        s.pending = false;
+        ++stats_.results;
+        if (!passed) stats_.conditionalSkipped += s.conditionalDraws;
+        s.conditionalDraws = 0;
+        if (!s.valid) continue;
+        s.visible = passed != 0;
+        // 被遮挡的物体本帧即重新查询；可见的隔若干帧，间隔按下标错开，避免同一帧集中重查
+        s.nextQuery = s.visible ? frame_ + kRequeryInterval + static_cast<unsigned>(i % kRequeryInterval) : frame_;
+    }
+}
+
+bool OcclusionQueries::select(size_t object, bool candidate, GLuint& condition) {
+    condition = 0;
+    if (object >= objects_.size()) return candidate;
+    ObjectState &s = objects_[object];
+    s.candidate = candidate;
+    if (!candidate) {
+        // 离开视锥后结果失效；重新进入时先照常绘制，并在当帧查询
+        s.valid = false;
+        s.visible = true;
+        s.nextQuery = frame_;
+        return false;
+    }
+    if (!s.valid) return true;
+    if (s.pending) {
+        condition = s.query;
+        ++s.conditionalDraws;
+        ++stats_.conditional;
+        return true;
+    }
+    if (!s.visible) {
+        ++stats_.skipped;
+        return false;
+    }
+    return true;
+}
+
+bool OcclusionQueries::crossesNearPlane(const glm::mat4& mvp, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 corner((i & 1) ? boundsMax.x : boundsMin.x, (i & 2) ? boundsMax.y : boundsMin.y,
+                         (i & 4) ? boundsMax.z : boundsMin.z, 1.0f);
+        glm::vec4 clip = mvp * corner;
+        if (clip.w <= 0.0f || clip.z < -clip.w) return true;
+    }
+    return false;
+}
+
+void OcclusionQueries::issue(const ObjectTransform* transforms, size_t count) {
+    const GLenum target = glExtensions().occlusionQueryTarget;
+    bool started = false;
+    count = std::min(count, objects_.size());
+    for (size_t i = 0; i < count; ++i) {
+        ObjectState &s = objects_[i];
+        if (!s.candidate || s.pending || frame_ < s.nextQuery) continue;
+        if (crossesNearPlane(transforms[i].mvp, boundsMin_, boundsMax_)) {
+            s.valid = true;
+            s.visible = true;
+            s.nextQuery = frame_ + 1;
+            continue;
+        }
+        if (!started) {
+            shader_.use();
+            glState().bindVertexArray(vao_);
+            glState().colorMask(false);
+            glState().depthMask(false);
+            started = true;
+        }
+        shader_.set(mvpUniform_, transforms[i].mvp);
+        glBeginQuery(target, s.query);
+        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, (void*)0);
+        glEndQuery(target);
+        s.pending = true;
+        s.valid = true;
+        ++stats_.issued;
+    }
+    if (started) {
+        glState().depthMask(true);
+        glState().colorMask(true);
+    }
+}
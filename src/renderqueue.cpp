@@ -0,0 +1,161 @@
+#include "renderqueue.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "glextensions.h"
+
+namespace {
+
+uint64_t field(unsigned value, int bits) {
+    return static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1);
+}
+
+}
+
+uint64_t makeSortKey(unsigned pass, unsigned program, unsigned material, unsigned vao, float depth) {
+    const float maxDepth = static_cast<float>((1u << kSortKeyDepthBits) - 1);
+    unsigned d = static_cast<unsigned>(std::min(std::max(depth, 0.0f), 1.0f) * maxDepth);
+    uint64_t key = field(pass, 4);
+    key = (key << kSortKeyProgramBits) | field(program, kSortKeyProgramBits);
+    key = (key << kSortKeyMaterialBits) | field(material, kSortKeyMaterialBits);
+    key = (key << kSortKeyVaoBits) | field(vao, kSortKeyVaoBits);
+    key = (key << kSortKeyDepthBits) | field(d, kSortKeyDepthBits);
+    return key << 4;
+}
+
+DrawCommand arrayDraw(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    DrawCommand d = DrawCommand();
+    d.mode = mode;
+    d.first = first;
+    d.count = count;
+    d.instances = instances;
+    return d;
+}
+
+DrawCommand indexedDraw(GLenum mode, GLenum indexType, GLsizei count, uintptr_t indexOffset, GLsizei instances) {
+    DrawCommand d = DrawCommand();
+    d.mode = mode;
+    d.indexType = indexType;
+    d.count = count;
+    d.indexOffset = indexOffset;
+    d.instances = instances;
+    return d;
+}
+
+DrawCommand multiIndexedDraw(GLenum mode, GLenum indexType, const GLsizei* counts, const void* const* offsets,
+                             GLsizei drawCount) {
+    DrawCommand d = DrawCommand();
+    d.mode = mode;
+    d.indexType = indexType;
+    d.counts = counts;
+    d.offsets = offsets;
+    d.drawCount = drawCount;
+    d.instances = 1;
+    return d;
+}
+
+DrawCommand indirectDraw(GLenum mode, GLenum indexType, uintptr_t commandOffset, GLsizei commandCount) {
+    DrawCommand d = DrawCommand();
+    d.mode = mode;
+    d.indexType = indexType;
+    d.commandOffset = commandOffset;
+    d.indirectCount = commandCount;
+    d.instances = 1;
+    return d;
+}
+
+void issueDraw(const DrawCommand& d) {
+    if (d.indirectCount > 0) {
+        glExtensions().multiDrawElementsIndirect(d.mode, d.indexType, reinterpret_cast<const void*>(d.commandOffset),
+                                                 d.indirectCount, 0);
+    } else if (d.drawCount > 0) {
+        glMultiDrawElements(d.mode, d.counts, d.indexType, d.offsets, d.drawCount);
+    } else if (d.indexType == 0) {
+        if (d.instances > 1) glDrawArraysInstanced(d.mode, d.first, d.count, d.instances);
+        else glDrawArrays(d.mode, d.first, d.count);
+    } else {
+        const void *indices = reinterpret_cast<const void*>(d.indexOffset);
+        if (d.instances > 1) glDrawElementsInstanced(d.mode, d.count, d.indexType, indices, d.instances);
+        else glDrawElements(d.mode, d.count, d.indexType, indices);
+    }
+}
+
+void RenderQueue::clear() {
+    items_.clear();
+    keys_.clear();
+    order_.clear();
+}
+
+unsigned RenderQueue::programIndex(const Shader* shader) {
+    for (size_t i = 0; i < programs_.size(); ++i) {
+        if (programs_[i] == shader) return static_cast<unsigned>(i);
+    }
+    programs_.push_back(shader);
+    return static_cast<unsigned>(programs_.size() - 1);
+}
+
+void RenderQueue::submit(const RenderItem& item) {
+    items_.push_back(item);
+    keys_.push_back(item.key);
+}
+
+void RenderQueue::sort() {
+    const size_t n = items_.size();
+    order_.resize(n);
+    for (size_t i = 0; i < n; ++i) order_[i] = static_cast<uint32_t>(i);
+    countChanges(items_, order_, submitted_);
+
+    keysTmp_.resize(n);
+    orderTmp_.resize(n);
+    // 只对键中实际出现差异的位做排序趟
+    uint64_t differing = 0;
+    for (size_t i = 1; i < n; ++i) differing |= keys_[i] ^ keys_[0];
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((differing >> shift) & 0xff) == 0) continue;
+        size_t offsets[256] = {0};
+        for (size_t i = 0; i < n; ++i) ++offsets[(keys_[i] >> shift) & 0xff];
+        size_t sum = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t c = offsets[b];
+            offsets[b] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t dst = offsets[(keys_[i] >> shift) & 0xff]++;
+            keysTmp_[dst] = keys_[i];
+            orderTmp_[dst] = order_[i];
+        }
+        keys_.swap(keysTmp_);
+        order_.swap(orderTmp_);
+    }
+    countChanges(items_, order_, sorted_);
+    ++frames_;
+}
+
+void RenderQueue::countChanges(const std::vector<RenderItem>& items, const std::vector<uint32_t>& order,
+                               RenderQueueStats& stats) {
+    const RenderItem *prev = NULL;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const RenderItem &item = items[order[i]];
+        if (!prev || item.shader != prev->shader) ++stats.programChanges;
+        if (!prev || item.material != prev->material) ++stats.materialChanges;
+        if (!prev || item.vao != prev->vao) ++stats.vaoChanges;
+        prev = &item;
+    }
+    stats.draws += static_cast<unsigned>(order.size());
+}
+
+void RenderQueue::report(std::ostream& out) const {
+    if (!frames_) return;
+    const float f = static_cast<float>(frames_);
+    out << "Render queue: " << sorted_.draws / f << " draws, program/material/VAO changes per frame "
+        << sorted_.programChanges / f << "/" << sorted_.materialChanges / f << "/" << sorted_.vaoChanges / f
+        << " sorted vs " << submitted_.programChanges / f << "/" << submitted_.materialChanges / f << "/"
+        << submitted_.vaoChanges / f << " in submission order over " << frames_ << " frames" << std::endl;
+}
+
+void RenderQueue::resetStats() {
+    sorted_ = submitted_ = RenderQueueStats();
+    frames_ = 0;
+}
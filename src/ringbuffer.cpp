@@ -0,0 +1,97 @@
+#include "ringbuffer.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "glextensions.h"
+#include "glstate.h"
+
+DynamicRingBuffer::DynamicRingBuffer()
+    : buffer_(0), mapped_(NULL), frameBytes_(0), uniformAlignment_(256), region_(kFrameRegions - 1), used_(0) {
+    for (int i = 0; i < kFrameRegions; ++i) fences_[i] = 0;
+    resetStats();
+}
+
+DynamicRingBuffer::~DynamicRingBuffer() {
+    for (int i = 0; i < kFrameRegions; ++i) {
+        if (fences_[i]) glDeleteSync(fences_[i]);
+    }
+    if (mapped_) {
+        glState().bindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glState().deleteBuffer(buffer_);
+}
+
+bool DynamicRingBuffer::create(size_t frameBytes) {
+    if (!glExtensions().bufferStorage || mapped_) return false;
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) uniformAlignment_ = static_cast<size_t>(alignment);
+    // 每个区域的起点也按 uniform 偏移对齐
+    frameBytes_ = (frameBytes + uniformAlignment_ - 1) / uniformAlignment_ * uniformAlignment_;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr total = static_cast<GLsizeiptr>(frameBytes_ * kFrameRegions);
+    glGenBuffers(1, &buffer_);
+    glState().bindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    glExtensions().bufferStorageEntry(GL_COPY_WRITE_BUFFER, total, NULL, flags);
+    mapped_ = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+    if (!mapped_) {
+        glState().deleteBuffer(buffer_);
+        buffer_ = 0;
+        return false;
+    }
+    return true;
+}
+
+void DynamicRingBuffer::beginFrame() {
+    if (!mapped_) return;
+    region_ = (region_ + 1) % kFrameRegions;
+    used_ = 0;
+    ++stats_.frames;
+    GLsync fence = fences_[region_];
+    if (!fence) return;
+    fences_[region_] = 0;
+    // 先不等待地查询一次；未完成才计为阻塞并等待
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++stats_.stalls;
+        auto t0 = std::chrono::steady_clock::now();
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        stats_.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    glDeleteSync(fence);
+}
+
+RingAllocation DynamicRingBuffer::allocate(size_t bytes, size_t alignment) {
+    RingAllocation a = {buffer_, 0, NULL};
+    if (!mapped_) return a;
+    size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+    if (offset + bytes > frameBytes_) return a;
+    used_ = offset + bytes;
+    stats_.bytes += bytes;
+    a.offset = static_cast<size_t>(region_) * frameBytes_ + offset;
+    a.data = mapped_ + a.offset;
+    return a;
+}
+
+void DynamicRingBuffer::endFrame() {
+    if (!mapped_) return;
+    if (fences_[region_]) glDeleteSync(fences_[region_]);
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void RingStats::report(std::ostream& out) const {
+    if (!frames) return;
+    out << "Dynamic ring: " << bytes / 1024.0 / frames << " KB per frame, " << stalls << " stalls, " << waitMs
+        << " ms waiting over " << frames << " frames" << std::endl;
+}
+
+void DynamicRingBuffer::resetStats() {
+    stats_.frames = stats_.stalls = 0;
+    stats_.waitMs = 0.0;
+    stats_.bytes = 0;
+}
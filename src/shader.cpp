@@ -1,73 +1,546 @@
 #include "shader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) : ID(0) {
-    std::string vCode = readFile(vertexPath);
-    std::string fCode = readFile(fragmentPath);
+#include "glextensions.h"
+#include "glstate.h"
+#include "hash.h"
 
-    unsigned int vShader = compileShader(GL_VERTEX_SHADER, vCode);
-    unsigned int fShader = compileShader(GL_FRAGMENT_SHADER, fCode);
+UniformStats Shader::stats_ = {0, 0};
 
+void UniformStats::report(std::ostream& out, unsigned frames) const {
+    if (!frames) return;
+    out << "Uniforms: " << static_cast<float>(issued) / frames << " issued, " << static_cast<float>(skipped) / frames
+        << " skipped per frame over " << frames << " frames" << std::endl;
+}
+bool Shader::binaryCacheEnabled_ = true;
+
+namespace {
+
+// Declarations shared by all vertex and fragment stages, see Shader::readFile
+const char kPreambleFile[] = "common.glsl";
+
+bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+bool hasExtension(const std::string& path, const char* extension) {
+    const size_t n = std::strlen(extension);
+    return path.size() >= n && path.compare(path.size() - n, n, extension) == 0;
+}
+
+// Handle types that may bind to several GLSL types (int covers bool and samplers)
+bool typeCompatible(GLenum expected, GLenum actual) {
+    if (expected == actual) return true;
+    if (expected == GL_INT) {
+        return actual == GL_BOOL || actual == GL_SAMPLER_2D || actual == GL_SAMPLER_3D ||
+               actual == GL_SAMPLER_CUBE || actual == GL_SAMPLER_2D_SHADOW;
+    }
+    return false;
+}
+
+// Program binary cache file (<vertex shader>.glprog):
+//   ProgramCacheHeader | driver binary
+// The key covers both sources and the GL vendor/renderer/version, so a driver
+// update or an edited shader invalidates the entry.
+const char kProgramMagic[8] = {'P', 'S', 'P', 'R', 'O', 'G', 0, 0};
+const uint32_t kProgramCacheVersion = 1;
+
+struct ProgramCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint64_t key;
+    uint64_t binaryBytes;
+};
+
+std::string glString(GLenum name) {
+    const GLubyte* s = glGetString(name);
+    return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+}
+
+uint64_t programKey(const std::string& vCode, const std::string& fCode) {
+    uint64_t key = hash64(vCode);
+    key = hash64(fCode, key);
+    key = hash64(glString(GL_VENDOR), key);
+    key = hash64(glString(GL_RENDERER), key);
+    return hash64(glString(GL_VERSION), key);
+}
+
+// glGetProgramBinary is core in GL 4.1; older contexts leave the pointers null
+bool programBinarySupported() {
+    if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+bool binaryFormatSupported(GLenum format) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    if (count <= 0) return false;
+    std::vector<GLint> formats(count);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+    return std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) != formats.end();
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+Shader::Shader()
+    : ID(0), state_(SHADER_EMPTY), vShader_(0), fShader_(0), key_(0), useCache_(false), separable_(false),
+      pipeline_(0) {
+    stages_[kVertexStage] = stages_[kFragmentStage] = NULL;
+}
+
+Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) : Shader() {
+    compile(vertexPath, fragmentPath);
+    finish();
+}
+
+void Shader::compile(const std::string& vertexPath, const std::string& fragmentPath,
+                     const std::vector<std::string>& defines) {
+    if (state_ != SHADER_EMPTY) return;
+    start_ = std::chrono::steady_clock::now();
+    std::string vCode = readFile(vertexPath, defines);
+    std::string fCode = readFile(fragmentPath, defines);
+
+    // Each permutation has its own cache entry; the key covers the injected defines too
+    std::string defineList;
+    for (size_t i = 0; i < defines.size(); ++i) defineList += (i ? " " : "") + defines[i];
+    useCache_ = binaryCacheEnabled_ && programBinarySupported();
+    cachePath_ = vertexPath;
+    if (!defines.empty()) {
+        char suffix[20];
+        snprintf(suffix, sizeof(suffix), ".%08x", static_cast<unsigned>(hash64(defineList)));
+        cachePath_ += suffix;
+    }
+    cachePath_ += ".glprog";
+    key_ = useCache_ ? programKey(vCode, fCode) : 0;
+    label_ = baseName(vertexPath) + " + " + baseName(fragmentPath);
+    if (!defines.empty()) label_ += " [" + defineList + "]";
+
+    if (loadCached()) return;
+
+    // Issue both compiles and the link without querying any status, so a driver
+    // with parallel compilation can overlap them with other work
+    vShader_ = compileShader(GL_VERTEX_SHADER, vCode);
+    fShader_ = compileShader(GL_FRAGMENT_SHADER, fCode);
+    link();
+}
+
+void Shader::compileStage(GLenum type, const std::string& path, const std::string& source) {
+    if (state_ != SHADER_EMPTY) return;
+    start_ = std::chrono::steady_clock::now();
+    separable_ = true;
+
+    // Stages are shared by source text: the cache entry (stage-<hash>.glprog next to the
+    // source) is named after the text, whichever file it was read from
+    char hex[16];
+    snprintf(hex, sizeof(hex), "%08x", static_cast<unsigned>(hash64(source)));
+    size_t slash = path.find_last_of("/\\");
+    useCache_ = binaryCacheEnabled_ && programBinarySupported();
+    cachePath_ = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + "stage-" + hex + ".glprog";
+    key_ = useCache_ ? programKey(source, "separable " + std::to_string(type)) : 0;
+    label_ = baseName(path) + " [stage " + hex + "]";
+
+    if (loadCached()) return;
+
+    unsigned int shader = compileShader(type, source);
+    if (type == GL_VERTEX_SHADER) vShader_ = shader;
+    else fShader_ = shader;
+    link();
+}
+
+void Shader::linkPipeline(Shader& vertexStage, Shader& fragmentStage) {
+    if (state_ != SHADER_EMPTY) return;
+    stages_[kVertexStage] = &vertexStage;
+    stages_[kFragmentStage] = &fragmentStage;
+    label_ = vertexStage.label_ + " | " + fragmentStage.label_;
+    // The pipeline object is created in finish(), once both stages are linked
+    state_ = SHADER_COMPILING;
+}
+
+bool Shader::loadCached() {
+    if (!useCache_ || !loadBinary(cachePath_, key_)) return false;
+    state_ = SHADER_READY;
+    std::cout << "Shader " << label_ << ": loaded from binary cache in " << elapsedMs(start_) << " ms" << std::endl;
+    reflectUniforms();
+    return true;
+}
+
+void Shader::link() {
     ID = glCreateProgram();
-    glAttachShader(ID, vShader);
-    glAttachShader(ID, fShader);
+    if (separable_) glProgramParameteri(ID, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    if (vShader_) glAttachShader(ID, vShader_);
+    if (fShader_) glAttachShader(ID, fShader_);
+    if (useCache_) glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
+    state_ = SHADER_COMPILING;
+}
+
+bool Shader::ready() const {
+    if (state_ != SHADER_COMPILING) return true;
+    if (stages_[kVertexStage]) return stages_[kVertexStage]->ready() && stages_[kFragmentStage]->ready();
+    if (!glExtensions().parallelShaderCompile) return true;
+    GLint done = GL_FALSE;
+    glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+bool Shader::finish() {
+    if (state_ != SHADER_COMPILING) return state_ == SHADER_READY;
+    if (stages_[kVertexStage]) return finishPipeline();
 
     int success;
     char infoLog[512];
+    if (vShader_) checkShader(vShader_, GL_VERTEX_SHADER);
+    if (fShader_) checkShader(fShader_, GL_FRAGMENT_SHADER);
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success) {
         glGetProgramInfoLog(ID, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
 
-    glDeleteShader(vShader);
-    glDeleteShader(fShader);
+    if (vShader_) {
+        glDetachShader(ID, vShader_);
+        glDeleteShader(vShader_);
+    }
+    if (fShader_) {
+        glDetachShader(ID, fShader_);
+        glDeleteShader(fShader_);
+    }
+    vShader_ = fShader_ = 0;
+
+    std::cout << "Shader " << label_ << ": compiled from source in " << elapsedMs(start_) << " ms" << std::endl;
+    if (!success) {
+        state_ = SHADER_FAILED;
+        return false;
+    }
+    state_ = SHADER_READY;
+    if (useCache_ && !saveBinary(cachePath_, key_)) {
+        std::cout << "WARNING::SHADER::CANNOT_WRITE_BINARY_CACHE: " << cachePath_ << std::endl;
+    }
+    reflectUniforms();
+    return true;
 }
 
-Shader::~Shader() {
-    if (ID) {
-        glDeleteProgram(ID);
+bool Shader::finishPipeline() {
+    bool vertexOk = stages_[kVertexStage]->finish();
+    bool fragmentOk = stages_[kFragmentStage]->finish();
+    if (!vertexOk || !fragmentOk) {
+        state_ = SHADER_FAILED;
+        return false;
     }
+    glGenProgramPipelines(1, &pipeline_);
+    glUseProgramStages(pipeline_, GL_VERTEX_SHADER_BIT, stages_[kVertexStage]->ID);
+    glUseProgramStages(pipeline_, GL_FRAGMENT_SHADER_BIT, stages_[kFragmentStage]->ID);
+
+    // Report interface mismatches between the stages now rather than at the first draw
+    GLint valid = GL_FALSE;
+    glValidateProgramPipeline(pipeline_);
+    glGetProgramPipelineiv(pipeline_, GL_VALIDATE_STATUS, &valid);
+    if (!valid) {
+        char infoLog[512];
+        glGetProgramPipelineInfoLog(pipeline_, 512, NULL, infoLog);
+        std::cout << "WARNING::SHADER::PIPELINE_VALIDATION_FAILED: " << label_ << "\n" << infoLog << std::endl;
+    }
+    routeUniforms();
+    state_ = SHADER_READY;
+    return true;
+}
+
+Shader::~Shader() {
+    glState().deleteProgramPipeline(pipeline_);
+    glState().deleteProgram(ID);
 }
 
 void Shader::use() const {
-    glUseProgram(ID);
+    if (pipeline_) {
+        // A program made current with glUseProgram would take precedence over the pipeline
+        glState().useProgram(0);
+        glState().bindProgramPipeline(pipeline_);
+        return;
+    }
+    glState().useProgram(ID);
 }
 
-void Shader::setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+void Shader::reflectUniforms() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i) {
+        UniformInfo u;
+        GLsizei length = 0;
+        glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length,
+                           &u.size, &u.type, name.data());
+        u.name.assign(name.data(), length);
+        u.location = glGetUniformLocation(ID, u.name.c_str());
+        if (u.location < 0) continue; // member of a uniform block
+        // Arrays are reported as "name[0]"; register them under the plain name as well
+        if (u.name.size() > 3 && u.name.compare(u.name.size() - 3, 3, "[0]") == 0) {
+            u.name.erase(u.name.size() - 3);
+        }
+        u.hasValue = false;
+        uniformSlots_[u.name] = static_cast<int>(uniforms_.size());
+        uniforms_.push_back(u);
+    }
 }
 
-void Shader::setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::routeUniforms() {
+    for (int s = 0; s < kPipelineStages; ++s) {
+        const std::vector<UniformInfo> &stageUniforms = stages_[s]->uniforms_;
+        for (size_t i = 0; i < stageUniforms.size(); ++i) {
+            auto it = uniformSlots_.find(stageUniforms[i].name);
+            int route;
+            if (it == uniformSlots_.end()) {
+                UniformRoute r;
+                r.slot[kVertexStage] = r.slot[kFragmentStage] = -1;
+                route = static_cast<int>(routes_.size());
+                routes_.push_back(r);
+                uniformSlots_[stageUniforms[i].name] = route;
+            } else {
+                route = it->second;
+            }
+            routes_[route].slot[s] = static_cast<int>(i);
+        }
+    }
 }
 
-void Shader::setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+int Shader::findUniform(const std::string& name, GLenum type) const {
+    auto it = uniformSlots_.find(name);
+    if (it == uniformSlots_.end()) return -1;
+    const UniformInfo *info = NULL;
+    if (stages_[kVertexStage]) {
+        const UniformRoute &r = routes_[it->second];
+        int s = r.slot[kVertexStage] >= 0 ? kVertexStage : kFragmentStage;
+        info = &stages_[s]->uniforms_[r.slot[s]];
+    } else {
+        info = &uniforms_[it->second];
+    }
+    const UniformInfo &u = *info;
+    if (!typeCompatible(type, u.type)) {
+        std::cout << "WARNING::SHADER::UNIFORM_TYPE_MISMATCH: " << name << std::endl;
+        return -1;
+    }
+    return it->second;
 }
 
-void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+bool Shader::changed(int slot, const void* value, size_t bytes) {
+    if (slot < 0) {
+        ++stats_.skipped;
+        return false;
+    }
+    UniformInfo &u = uniforms_[slot];
+    if (u.hasValue && memcmp(u.value, value, bytes) == 0) {
+        ++stats_.skipped;
+        return false;
+    }
+    memcpy(u.value, value, bytes);
+    u.hasValue = true;
+    ++stats_.issued;
+    return true;
 }
 
-void Shader::setVec3(const std::string &name, const glm::vec3 &vec) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(vec));
+void Shader::bindUniformBlock(const std::string& name, GLuint binding) {
+    if (stages_[kVertexStage]) {
+        stages_[kVertexStage]->bindUniformBlock(name, binding);
+        stages_[kFragmentStage]->bindUniformBlock(name, binding);
+        return;
+    }
+    GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(ID, index, binding);
 }
 
-std::string Shader::readFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
+// Separable stages are not current, so they are written with glProgramUniform*
+void Shader::set(Uniform<int> u, int value) {
+    if (stages_[kVertexStage]) return setStages(u, value);
+    if (!changed(u.slot, &value, sizeof(value))) return;
+    if (separable_) glProgramUniform1i(ID, uniforms_[u.slot].location, value);
+    else glUniform1i(uniforms_[u.slot].location, value);
+}
+
+void Shader::set(Uniform<float> u, float value) {
+    if (stages_[kVertexStage]) return setStages(u, value);
+    if (!changed(u.slot, &value, sizeof(value))) return;
+    if (separable_) glProgramUniform1f(ID, uniforms_[u.slot].location, value);
+    else glUniform1f(uniforms_[u.slot].location, value);
+}
+
+void Shader::set(Uniform<glm::vec3> u, const glm::vec3& value) {
+    if (stages_[kVertexStage]) return setStages(u, value);
+    if (!changed(u.slot, glm::value_ptr(value), sizeof(value))) return;
+    if (separable_) glProgramUniform3fv(ID, uniforms_[u.slot].location, 1, glm::value_ptr(value));
+    else glUniform3fv(uniforms_[u.slot].location, 1, glm::value_ptr(value));
+}
+
+void Shader::set(Uniform<glm::mat3> u, const glm::mat3& value) {
+    if (stages_[kVertexStage]) return setStages(u, value);
+    if (!changed(u.slot, glm::value_ptr(value), sizeof(value))) return;
+    if (separable_) glProgramUniformMatrix3fv(ID, uniforms_[u.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    else glUniformMatrix3fv(uniforms_[u.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::set(Uniform<glm::mat4> u, const glm::mat4& value) {
+    if (stages_[kVertexStage]) return setStages(u, value);
+    if (!changed(u.slot, glm::value_ptr(value), sizeof(value))) return;
+    if (separable_) glProgramUniformMatrix4fv(ID, uniforms_[u.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+    else glUniformMatrix4fv(uniforms_[u.slot].location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::setBool(const std::string &name, bool value) {
+    set(uniform<int>(name), (int)value);
+}
+
+void Shader::setInt(const std::string &name, int value) {
+    set(uniform<int>(name), value);
+}
+
+void Shader::setFloat(const std::string &name, float value) {
+    set(uniform<float>(name), value);
+}
+
+void Shader::setMat4(const std::string &name, const glm::mat4 &mat) {
+    set(uniform<glm::mat4>(name), mat);
+}
+
+void Shader::setVec3(const std::string &name, const glm::vec3 &vec) {
+    set(uniform<glm::vec3>(name), vec);
+}
+
+bool Shader::loadBinary(const std::string& path, uint64_t key) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in.is_open()) return false;
+    ProgramCacheHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+    if (memcmp(h.magic, kProgramMagic, sizeof(kProgramMagic)) != 0 || h.version != kProgramCacheVersion ||
+        h.key != key || h.binaryBytes == 0 || !binaryFormatSupported(h.binaryFormat)) {
+        return false;
+    }
+    std::vector<char> binary(static_cast<size_t>(h.binaryBytes));
+    if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size()))) return false;
+
+    ID = glCreateProgram();
+    if (separable_) glProgramParameteri(ID, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(ID, h.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success) {
+        // The driver may reject binaries from another build; fall back to source
+        std::cout << "WARNING::SHADER::BINARY_REJECTED: " << path << std::endl;
+        glState().deleteProgram(ID);
+        ID = 0;
+        return false;
+    }
+    return true;
+}
+
+bool Shader::saveBinary(const std::string& path, uint64_t key) const {
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(ID, length, &written, &format, binary.data());
+    if (written <= 0) return false;
+
+    ProgramCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kProgramMagic, sizeof(kProgramMagic));
+    h.version = kProgramCacheVersion;
+    h.binaryFormat = format;
+    h.key = key;
+    h.binaryBytes = static_cast<uint64_t>(written);
+
+    // Write a temporary file and rename so a concurrent reader never sees a partial entry
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(binary.data(), written);
+        if (!out.good()) {
+            out.close();
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string Shader::readFile(const std::string& path, const std::vector<std::string>& defines) {
+    std::string source;
+    if (!readText(path, source)) {
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
         return std::string();
     }
-    std::stringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
+
+    // Vertex and fragment stages get the shared preamble (kPreambleFile next to the stage)
+    std::string preamble;
+    if (hasExtension(path, ".vs") || hasExtension(path, ".fs")) {
+        const std::string preamblePath = path.substr(0, path.find_last_of("/\\") + 1) + kPreambleFile;
+        if (!readText(preamblePath, preamble)) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << preamblePath << std::endl;
+        }
+    }
+
+    // #version must stay first: insert the defines after it and restore line numbering
+    size_t insertAt = 0;
+    int nextLine = 1;
+    if (source.compare(0, 8, "#version") == 0) {
+        size_t eol = source.find('\n');
+        if (eol == std::string::npos) {
+            source += '\n';
+            eol = source.size() - 1;
+        }
+        insertAt = eol + 1;
+        nextLine = 2;
+    }
+    // Only defines the stage itself mentions: the preamble alone must not split otherwise identical stages
+    std::string injected;
+    for (size_t i = 0; i < defines.size(); ++i) {
+        std::string name = defines[i].substr(0, defines[i].find(' '));
+        if (source.find(name) != std::string::npos) injected += "#define " + defines[i] + "\n";
+    }
+    // Preamble lines are reported as source string 1, the stage itself as source string 0
+    if (!preamble.empty()) {
+        injected += "#line 1 1\n" + preamble;
+        if (preamble[preamble.size() - 1] != '\n') injected += '\n';
+    }
+    if (injected.empty()) return source;
+    injected += "#line " + std::to_string(nextLine) + (preamble.empty() ? "\n" : " 0\n");
+    return source.insert(insertAt, injected);
 }
 
 unsigned int Shader::compileShader(GLenum type, const std::string& source) {
@@ -75,7 +548,10 @@ unsigned int Shader::compileShader(GLenum type, const std::string& source) {
     const char* src = source.c_str();
     glShaderSource(shader, 1, &src, NULL);
     glCompileShader(shader);
+    return shader;
+}
 
+void Shader::checkShader(unsigned int shader, GLenum type) {
     int success;
     char infoLog[512];
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -84,5 +560,4 @@ unsigned int Shader::compileShader(GLenum type, const std::string& source) {
         std::cout << "ERROR::SHADER::" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT")
                   << "::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
-    return shader;
 }
@@ -0,0 +1,10 @@
+#version 330 core
+// 遮挡查询的包围盒（见 occlusionquery.h）：只做深度测试，颜色与深度写入均关闭
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 uMVP;
+
+void main()
+{
+    gl_Position = uMVP * vec4(aPos, 1.0);
+}
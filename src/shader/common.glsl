@@ -0,0 +1,85 @@
+// 顶点 / 片元着色器共享的声明，由 Shader::readFile 注入到各 .vs / .fs 的 #version 之后
+// （本文件的行号以源串 1 报告）。只含声明与函数，未用到的部分由编译器剔除
+
+// 量化顶点解码（布局见 vertexformat.h）
+uniform vec3 uPosScale;      // 量化位置反量化：pos = uPosOffset + uPosScale * aPos
+uniform vec3 uPosOffset;
+uniform int uNormalEncoding; // 0: aNormal.xyz，1: 八面体编码 aNormal.xy
+
+vec3 decodePosition(vec3 position)
+{
+    return uPosOffset + uPosScale * position;
+}
+
+vec3 decodeNormal(vec3 normal)
+{
+    if (uNormalEncoding == 1) {
+        vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+        float t = max(-n.z, 0.0);
+        n.x += n.x >= 0.0 ? -t : t;
+        n.y += n.y >= 0.0 ? -t : t;
+        return n;
+    }
+    return normal;
+}
+
+// 所有程序共享的 std140 uniform 块（绑定点见 uniformblocks.h），成员直接位于全局作用域
+layout(std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uViewPos;      // 世界空间相机位置
+};
+layout(std140) uniform LightBlock {
+    vec3 uLightPos;     // 世界空间光源位置
+    vec3 uLightColor;   // 光颜色
+};
+#ifdef INSTANCED
+// 实例化：材质表（与 MaterialBlock 布局相同，表长见 uniformblocks.h 的 kMaxInstanceMaterials），按实例下标选取
+struct Material {
+    vec3 objectColor;
+    float ambient;
+    vec3 albedo;
+    float roughness;
+    vec3 F0;
+    float metallic;
+    float specular;
+    float shininess;
+};
+layout(std140) uniform MaterialTable {
+    Material uMaterials[8];
+};
+
+// 与 MaterialBlock 成员同名的全局变量，main 开头由 loadMaterial 填充，其余代码不变
+vec3 uObjectColor;
+float uAmbient;
+vec3 uAlbedo;
+float uRoughness;
+vec3 F0;
+float uMetallic;
+float uSpecular;
+float uShininess;
+
+void loadMaterial(uint index)
+{
+    Material m = uMaterials[index];
+    uObjectColor = m.objectColor;
+    uAmbient = m.ambient;
+    uAlbedo = m.albedo;
+    uRoughness = m.roughness;
+    F0 = m.F0;
+    uMetallic = m.metallic;
+    uSpecular = m.specular;
+    uShininess = m.shininess;
+}
+#else
+layout(std140) uniform MaterialBlock {
+    vec3 uObjectColor;  // 物体基底颜色（Phong / Gouraud）
+    float uAmbient;     // 环境光强度
+    vec3 uAlbedo;       // 表面反射率/基础颜色 (linear)
+    float uRoughness;   // [0,1]
+    vec3 F0;            // [0,1]
+    float uMetallic;    // [0,1] 金属度：0=非金属，1=金属
+    float uSpecular;    // 高光强度系数（Phong / Gouraud）
+    float uShininess;   // 高光次幂（Phong / Gouraud）
+};
+#endif
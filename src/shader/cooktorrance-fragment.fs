@@ -3,16 +3,9 @@ in vec3 vNormal;
 in vec3 vFragPos;
 out vec4 FragColor;
 
-uniform vec3 uLightPos;     // world-space light position
-uniform vec3 uViewPos;      // world-space camera position
-uniform vec3 uLightColor;   // light color (radiance)
-
-// PBR material parameters
-uniform vec3 uAlbedo;         // 表面反射率/基础颜色 (linear)
-uniform vec3 F0;    // [0,1]
-uniform float uRoughness;   // [0,1]
-uniform float uMetallic;    // [0,1] 金属度：0=非金属，1=金属
-uniform float uAmbient;   // 环境光强度
+#ifdef INSTANCED
+flat in uint vMaterial;     // material table index (table and uniform blocks in common.glsl)
+#endif
 
 const float PI = 3.14159265359;
 
@@ -42,11 +35,19 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float k)
 
 vec3 fresnelSchlick(float cosTheta, vec3 F0)
 {
+#ifdef FAST_FRESNEL
+    // Spherical Gaussian approximation of (1 - cosTheta)^5, avoids pow (not exact)
+    return F0 + (1.0 - F0) * exp2((-5.55473 * cosTheta - 6.98316) * cosTheta);
+#else
     return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+#endif
 }
 
 void main()
 {
+#ifdef INSTANCED
+    loadMaterial(vMaterial);
+#endif
     // Normalized inputs
     vec3 N = normalize(vNormal);
     vec3 V = normalize(uViewPos - vFragPos);
@@ -59,7 +60,14 @@ void main()
     float NdotL = max(dot(N, L), 0.0);
     float cosTheta = max(dot(H, V), 0.0); // Fresnel uses angle between V and H
 
+    // Permutations for materials with uMetallic exactly 1 or 0
+#if defined(METALLIC_ONLY)
+    vec3 F0_calculated = uAlbedo;
+#elif defined(DIELECTRIC_ONLY)
+    vec3 F0_calculated = vec3(0.04);
+#else
     vec3 F0_calculated = mix(vec3(0.04), uAlbedo, uMetallic);
+#endif
 
     // Cook-Torrance BRDF components
     float D = DistributionGGX(N, H, a);
@@ -69,13 +77,25 @@ void main()
     float denom = max(4.0 * NdotV * NdotL, 1e-4);
     vec3 specular = (D * G * F) / denom;
 
+    vec3 radiance = uLightColor * NdotL;
+#if defined(METALLIC_ONLY)
+    // kd == 0: metals have no diffuse term
+    vec3 Lo = specular * radiance;
+    vec3 ambient = uAmbient * uLightColor * (uAlbedo * 0.5);
+#else
+#if defined(DIELECTRIC_ONLY)
+    vec3 kd = vec3(1.0) - F;
+#else
     vec3 kd = (vec3(1.0) - F) * (1.0 - uMetallic);
+#endif
     vec3 diffuse = kd * uAlbedo * (1.0 / PI);
-
-    vec3 radiance = uLightColor * NdotL;
     vec3 Lo = (diffuse + specular) * radiance;
-    
+#if defined(DIELECTRIC_ONLY)
+    vec3 ambient = uAmbient * uLightColor * uAlbedo;
+#else
     vec3 ambient = uAmbient * uLightColor * mix(uAlbedo, uAlbedo * 0.5, uMetallic);
+#endif
+#endif
 
     vec3 color = ambient + Lo;
     FragColor = vec4(color, 1.0);
@@ -5,13 +5,42 @@ layout (location = 1) in vec3 aNormal;
 out vec3 vNormal;
 out vec3 vFragPos;
 
+#ifdef INSTANCED
+// 逐实例属性（divisor 1，位置见 instancing.h），mat4 / mat3 各占连续 4 / 3 个位置
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in mat3 aNormalMatrix;
+layout (location = 9) in uint aMaterial;
+flat out uint vMaterial;     // 材质表下标，传给片元着色器
+#else
 uniform mat4 uMVP;
 uniform mat4 uModel;
+uniform mat3 uNormalMatrix;  // transpose(inverse(mat3(uModel)))，逐物体在 CPU 上计算
+#endif
+
+// --shader-transforms（VERTEX_NORMAL_MATRIX）：法线矩阵逐顶点由模型矩阵求逆，即移到 CPU 之前的做法，供 --gpu-timing 对比
+mat3 normalMatrix(mat4 model, mat3 precomputed)
+{
+#ifdef VERTEX_NORMAL_MATRIX
+    return transpose(inverse(mat3(model)));
+#else
+    return precomputed;
+#endif
+}
 
 void main()
 {
-    gl_Position = uMVP * vec4(aPos, 1.0);
-    vFragPos = vec3(uModel * vec4(aPos, 1.0));
-    mat3 normalMatrix = transpose(inverse(mat3(uModel)));
-    vNormal = normalize(normalMatrix * aNormal);
+    // 解码函数、各 uniform 块与 loadMaterial 见 common.glsl
+    vec3 pos = decodePosition(aPos);
+    vec3 normal = decodeNormal(aNormal);
+#ifdef INSTANCED
+    vec4 world = aModel * vec4(pos, 1.0);
+    gl_Position = uProj * (uView * world);
+    vFragPos = world.xyz;
+    vNormal = normalize(normalMatrix(aModel, aNormalMatrix) * normal);
+    vMaterial = aMaterial;
+#else
+    gl_Position = uMVP * vec4(pos, 1.0);
+    vFragPos = vec3(uModel * vec4(pos, 1.0));
+    vNormal = normalize(normalMatrix(uModel, uNormalMatrix) * normal);
+#endif
 }
@@ -4,23 +4,43 @@ layout (location = 1) in vec3 aNormal;
 
 out vec3 oColor;
 
+#ifdef INSTANCED
+// 逐实例属性（divisor 1，位置见 instancing.h），mat4 / mat3 各占连续 4 / 3 个位置
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in mat3 aNormalMatrix;
+layout (location = 9) in uint aMaterial;
+#else
 uniform mat4 uMVP;
 uniform mat4 uModel;
+uniform mat3 uNormalMatrix;  // transpose(inverse(mat3(uModel)))，逐物体在 CPU 上计算
+#endif
 
-uniform vec3 uLightPos;     // 世界空间光源位置
-uniform vec3 uViewPos;      // 世界空间相机位置
-uniform vec3 uLightColor;   // 光颜色
-uniform vec3 uObjectColor;  // 物体基底颜色
-uniform float uAmbient;   // 环境光强度
-uniform float uSpecular;  // 高光强度系数
-uniform float uShininess;         // 高光次幂
+// --shader-transforms（VERTEX_NORMAL_MATRIX）：法线矩阵逐顶点由模型矩阵求逆，即移到 CPU 之前的做法，供 --gpu-timing 对比
+mat3 normalMatrix(mat4 model, mat3 precomputed)
+{
+#ifdef VERTEX_NORMAL_MATRIX
+    return transpose(inverse(mat3(model)));
+#else
+    return precomputed;
+#endif
+}
 
 void main()
 {
-    gl_Position = uMVP * vec4(aPos, 1.0);
-    vec3 FragPos = vec3(uModel * vec4(aPos, 1.0));
-    mat3 normalMatrix = transpose(inverse(mat3(uModel)));
-    vec3 vNormal = normalize(normalMatrix * aNormal);
+    // 解码函数、各 uniform 块与 loadMaterial 见 common.glsl
+    vec3 pos = decodePosition(aPos);
+    vec3 normal = decodeNormal(aNormal);
+#ifdef INSTANCED
+    loadMaterial(aMaterial);
+    vec4 world = aModel * vec4(pos, 1.0);
+    gl_Position = uProj * (uView * world);
+    vec3 FragPos = world.xyz;
+    vec3 vNormal = normalize(normalMatrix(aModel, aNormalMatrix) * normal);
+#else
+    gl_Position = uMVP * vec4(pos, 1.0);
+    vec3 FragPos = vec3(uModel * vec4(pos, 1.0));
+    vec3 vNormal = normalize(normalMatrix(uModel, uNormalMatrix) * normal);
+#endif
     vec3 N = normalize(vNormal);
     vec3 L = normalize(uLightPos - FragPos);
     vec3 V = normalize(uViewPos - FragPos);
@@ -33,9 +53,13 @@ void main()
     float diff = max(dot(N, L), 0.0);
     vec3 diffuse = diff * uLightColor;
 
-    // 高光（Blinn-Phong）
+    // 高光（Blinn-Phong）；NO_SPECULAR 变体用于 uSpecular == 0 的材质
+#ifdef NO_SPECULAR
+    vec3 specular = vec3(0.0);
+#else
     float spec = pow(max(dot(N, H), 0.0), uShininess);
     vec3 specular = uSpecular * spec * uLightColor;
+#endif
 
     oColor = (ambient + diffuse + specular) * uObjectColor;
 }
@@ -3,16 +3,15 @@ in vec3 vNormal;
 in vec3 vFragPos;
 out vec4 FragColor;
 
-uniform vec3 uLightPos;     // 世界空间光源位置
-uniform vec3 uViewPos;      // 世界空间相机位置
-uniform vec3 uLightColor;   // 光颜色
-uniform vec3 uObjectColor;  // 物体基底颜色
-uniform float uAmbient;   // 环境光强度
-uniform float uSpecular;  // 高光强度系数
-uniform float uShininess;         // 高光次幂
+#ifdef INSTANCED
+flat in uint vMaterial;     // 材质表下标（材质表与各 uniform 块见 common.glsl）
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    loadMaterial(vMaterial);
+#endif
     // 法线与方向
     vec3 N = normalize(vNormal);
     vec3 L = normalize(uLightPos - vFragPos);
@@ -26,9 +25,13 @@ void main()
     float diff = max(dot(N, L), 0.0);
     vec3 diffuse = diff * uLightColor;
 
-    // 高光（Blinn-Phong）
+    // 高光（Blinn-Phong）；NO_SPECULAR 变体用于 uSpecular == 0 的材质
+#ifdef NO_SPECULAR
+    vec3 specular = vec3(0.0);
+#else
     float spec = pow(max(dot(N, H), 0.0), uShininess);
     vec3 specular = uSpecular * spec * uLightColor;
+#endif
 
     vec3 color = (ambient + diffuse + specular) * uObjectColor;
     FragColor = vec4(color, 1.0);
@@ -0,0 +1,160 @@
+#include "shadermanager.h"
+
+#include "glextensions.h"
+#include "hash.h"
+#include "uniformblocks.h"
+
+namespace {
+
+const char* const kVertexFiles[kShadingModelCount] = {
+    "phong-vertex.vs", "gouraud-vertex.vs", "cooktorrance-vertex.vs"};
+const char* const kFragmentFiles[kShadingModelCount] = {
+    "phong-fragment.fs", "gouraud-fragment.fs", "cooktorrance-fragment.fs"};
+const char* const kNames[kShadingModelCount] = {"phong", "gouraud", "cooktorrance"};
+
+const char* const kFeatureDefines[kShaderFeatureCount] = {
+    "METALLIC_ONLY", "DIELECTRIC_ONLY", "NO_SPECULAR", "FAST_FRESNEL", "INSTANCED", "VERTEX_NORMAL_MATRIX"};
+
+// Features each model's sources implement
+const unsigned kSupportedFeatures[kShadingModelCount] = {
+    SHADER_NO_SPECULAR | SHADER_INSTANCED | SHADER_VERTEX_NORMAL_MATRIX,
+    SHADER_NO_SPECULAR | SHADER_INSTANCED | SHADER_VERTEX_NORMAL_MATRIX,
+    SHADER_METALLIC_ONLY | SHADER_DIELECTRIC_ONLY | SHADER_FAST_FRESNEL | SHADER_INSTANCED |
+        SHADER_VERTEX_NORMAL_MATRIX};
+
+// Features only enabled on request
+const unsigned kOptInFeatures = SHADER_FAST_FRESNEL | SHADER_VERTEX_NORMAL_MATRIX;
+
+std::vector<std::string> featureDefines(unsigned features) {
+    std::vector<std::string> defines;
+    for (int i = 0; i < kShaderFeatureCount; ++i) {
+        if (features & (1u << i)) defines.push_back(kFeatureDefines[i]);
+    }
+    return defines;
+}
+
+} // namespace
+
+unsigned shaderFeaturesFor(ShadingModel model, const MaterialBlock& material, unsigned optIn) {
+    unsigned features = optIn & kOptInFeatures;
+    if (material.metallic == 1.0f) features |= SHADER_METALLIC_ONLY;
+    else if (material.metallic == 0.0f) features |= SHADER_DIELECTRIC_ONLY;
+    if (material.specular == 0.0f) features |= SHADER_NO_SPECULAR;
+    return features & kSupportedFeatures[model];
+}
+
+unsigned shaderFeaturesFor(ShadingModel model, const MaterialBlock* materials, unsigned count, unsigned optIn) {
+    unsigned features = kSupportedFeatures[model];
+    for (unsigned i = 0; i < count; ++i) features &= shaderFeaturesFor(model, materials[i], optIn);
+    return features;
+}
+
+ShaderManager::ShaderManager(const std::string& shaderDir, bool separable)
+    : dir_(shaderDir), separable_(separable && glExtensions().separateShaderObjects) {
+    // Let the driver use as many compiler threads as it likes
+    const GLExtensions &ext = glExtensions();
+    if (ext.parallelShaderCompile && ext.maxShaderCompilerThreads) ext.maxShaderCompilerThreads(0xFFFFFFFFu);
+}
+
+const char* ShaderManager::name(ShadingModel model) {
+    return kNames[model];
+}
+
+std::string ShaderManager::describe(ShadingModel model, unsigned features) {
+    std::string s = kNames[model];
+    std::vector<std::string> defines = featureDefines(features);
+    for (size_t i = 0; i < defines.size(); ++i) s += (i ? " " : " [") + defines[i];
+    if (!defines.empty()) s += "]";
+    return s;
+}
+
+Shader& ShaderManager::get(ShadingModel model, unsigned features) {
+    Program &p = program(model, features);
+    start(p);
+    finalize(p);
+    p.queued = false;
+    return p.shader;
+}
+
+void ShaderManager::warm(ShadingModel model, unsigned features) {
+    Program &p = program(model, features);
+    if (p.shader.linked() || p.shader.pending()) return;
+    p.queued = true;
+}
+
+void ShaderManager::update() {
+    if (glExtensions().parallelShaderCompile) {
+        // Issue every queued compile before checking any status
+        for (auto it = programs_.begin(); it != programs_.end(); ++it) {
+            if (it->second->queued) start(*it->second);
+        }
+        for (auto it = programs_.begin(); it != programs_.end(); ++it) {
+            Program &p = *it->second;
+            if (p.queued && p.shader.ready()) {
+                finalize(p);
+                p.queued = false;
+            }
+        }
+        return;
+    }
+    // Compiling is synchronous: spread the programs over frames
+    for (auto it = programs_.begin(); it != programs_.end(); ++it) {
+        Program &p = *it->second;
+        if (!p.queued) continue;
+        start(p);
+        finalize(p);
+        p.queued = false;
+        break;
+    }
+}
+
+bool ShaderManager::idle() const {
+    for (auto it = programs_.begin(); it != programs_.end(); ++it) {
+        if (it->second->queued) return false;
+    }
+    return true;
+}
+
+ShaderManager::Program& ShaderManager::program(ShadingModel model, unsigned features) {
+    features &= kSupportedFeatures[model];
+    std::unique_ptr<Program> &slot = programs_[(static_cast<unsigned>(model) << 16) | features];
+    if (!slot) {
+        slot.reset(new Program());
+        slot->model = model;
+        slot->features = features;
+        slot->queued = slot->bound = false;
+    }
+    return *slot;
+}
+
+void ShaderManager::start(Program& p) {
+    if (p.shader.linked() || p.shader.pending()) return;
+    const std::string vertexPath = dir_ + "/" + kVertexFiles[p.model];
+    const std::string fragmentPath = dir_ + "/" + kFragmentFiles[p.model];
+    const std::vector<std::string> defines = featureDefines(p.features);
+    if (!separable_) {
+        p.shader.compile(vertexPath, fragmentPath, defines);
+        return;
+    }
+    Shader &vertexStage = stage(GL_VERTEX_SHADER, vertexPath, defines);
+    Shader &fragmentStage = stage(GL_FRAGMENT_SHADER, fragmentPath, defines);
+    p.shader.linkPipeline(vertexStage, fragmentStage);
+}
+
+Shader& ShaderManager::stage(GLenum type, const std::string& path, const std::vector<std::string>& defines) {
+    const std::string source = Shader::readFile(path, defines);
+    std::unique_ptr<Shader> &slot = stages_[hash64(source, type)];
+    if (!slot) {
+        slot.reset(new Shader());
+        slot->compileStage(type, path, source);
+    }
+    return *slot;
+}
+
+void ShaderManager::finalize(Program& p) {
+    p.shader.finish();
+    if (p.shader.linked() && !p.bound) {
+        bindUniformBlocks(p.shader);
+        p.bound = true;
+    }
+}
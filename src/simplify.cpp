@@ -0,0 +1,328 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "meshopt.h"
+#include "threadpool.h"
+
+namespace {
+
+const float kFlipThreshold = 0.2f; // 折叠后面法线与原法线夹角余弦低于此值视为翻转
+const float kNormalWeight = 1.0f;  // 法线误差权重
+const float kErrorGoalSlack = 1.5f; // 每轮只折叠代价不超过目标位置处 1.5 倍的边
+
+// 对称 3×3 矩阵 A、向量 b、常数 c 表示的二次误差，w 为累计面积权重
+struct Quadric {
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double w;
+};
+
+void quadricAdd(Quadric& q, const Quadric& r) {
+    q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+    q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+    q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+    q.c += r.c;
+    q.w += r.w;
+}
+
+// 平面 n·p + d = 0 按面积 weight 加权的二次误差
+Quadric planeQuadric(const glm::dvec3& n, double d, double weight) {
+    Quadric q;
+    q.a00 = weight * n.x * n.x; q.a11 = weight * n.y * n.y; q.a22 = weight * n.z * n.z;
+    q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a12 = weight * n.y * n.z;
+    q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+    q.c = weight * d * d;
+    q.w = weight;
+    return q;
+}
+
+// 到各平面距离平方的面积加权平均
+double quadricError(const Quadric& q, const glm::vec3& p) {
+    const double x = p.x, y = p.y, z = p.z;
+    double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+               2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+               2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.w > 0.0 ? std::max(e, 0.0) / q.w : 0.0;
+}
+
+// 所有 LOD 级共享的只读预处理结果
+struct SimplifyContext {
+    std::vector<glm::vec3> positions; // 归一化到单位包围盒
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned char> locked;
+    std::vector<Quadric> quadrics;    // 初始顶点二次误差
+    float scale;                      // 归一化比例，用于还原模型空间距离
+};
+
+void buildContext(const Mesh& mesh, const std::vector<unsigned int>& indices, SimplifyContext& ctx) {
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    glm::vec3 lo, hi;
+    mesh.computeBounds(lo, hi);
+    glm::vec3 extent = hi - lo;
+    ctx.scale = std::max(extent.x, std::max(extent.y, extent.z));
+    const float inv = ctx.scale > 0.0f ? 1.0f / ctx.scale : 0.0f;
+    ctx.positions.resize(vertexCount);
+    ctx.normals.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const float *src = &mesh.vertices[v * 6];
+        ctx.positions[v] = (glm::vec3(src[0], src[1], src[2]) - lo) * inv;
+        glm::vec3 n(src[3], src[4], src[5]);
+        float len = glm::length(n);
+        ctx.normals[v] = len > 0.0f ? n / len : n;
+    }
+
+    // 按位置焊接：同一位置有多个顶点即为属性接缝
+    struct WeldKey {
+        float p[3];
+        unsigned int v;
+        bool operator<(const WeldKey& o) const {
+            if (p[0] != o.p[0]) return p[0] < o.p[0];
+            if (p[1] != o.p[1]) return p[1] < o.p[1];
+            if (p[2] != o.p[2]) return p[2] < o.p[2];
+            return v < o.v;
+        }
+    };
+    std::vector<WeldKey> keys(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        memcpy(keys[v].p, &mesh.vertices[v * 6], 3 * sizeof(float));
+        keys[v].v = static_cast<unsigned int>(v);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<unsigned int> weld(vertexCount);
+    ctx.locked.assign(vertexCount, 0);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        bool same = i > 0 && memcmp(keys[i].p, keys[i - 1].p, sizeof(keys[i].p)) == 0;
+        weld[keys[i].v] = same ? weld[keys[i - 1].v] : keys[i].v;
+        if (same) ctx.locked[keys[i].v] = ctx.locked[keys[i - 1].v] = 1;
+    }
+    std::vector<WeldKey>().swap(keys);
+
+    // 边界：焊接后有向边 a->b 没有反向边 b->a 与之配对；按起点建出边表后局部查找
+    std::vector<unsigned int> outOffsets(vertexCount + 1, 0), outEdges(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) outOffsets[weld[indices[i]] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v) outOffsets[v + 1] += outOffsets[v];
+    {
+        std::vector<unsigned int> fill(outOffsets.begin(), outOffsets.end() - 1);
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int a = weld[indices[t + k]], b = weld[indices[t + (k + 1) % 3]];
+                outEdges[fill[a]++] = b;
+            }
+        }
+    }
+    std::vector<unsigned char> borderWeld(vertexCount, 0);
+    for (size_t a = 0; a < vertexCount; ++a) {
+        for (unsigned int e = outOffsets[a]; e < outOffsets[a + 1]; ++e) {
+            unsigned int b = outEdges[e];
+            if (b == a) continue;
+            bool paired = false;
+            for (unsigned int r = outOffsets[b]; r < outOffsets[b + 1] && !paired; ++r) paired = outEdges[r] == a;
+            if (!paired) borderWeld[a] = borderWeld[b] = 1;
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (borderWeld[weld[v]]) ctx.locked[v] = 1;
+    }
+
+    // 顶点二次误差：相邻三角形平面按面积加权累加
+    Quadric zero;
+    memset(&zero, 0, sizeof(zero));
+    ctx.quadrics.assign(vertexCount, zero);
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        glm::dvec3 p0(ctx.positions[indices[t]]);
+        glm::dvec3 p1(ctx.positions[indices[t + 1]]);
+        glm::dvec3 p2(ctx.positions[indices[t + 2]]);
+        glm::dvec3 c = glm::cross(p1 - p0, p2 - p0);
+        double len = glm::length(c);
+        if (len <= 0.0) continue;
+        glm::dvec3 n = c / len;
+        Quadric q = planeQuadric(n, -glm::dot(n, p0), len * 0.5);
+        for (int k = 0; k < 3; ++k) quadricAdd(ctx.quadrics[indices[t + k]], q);
+    }
+}
+
+struct Collapse {
+    unsigned int u, v; // u 折叠到 v
+    float cost;
+    float positionError;
+};
+
+inline bool collapseLess(const Collapse& a, const Collapse& b) { return a.cost < b.cost; }
+
+// 折叠 u -> v 后 u 的相邻三角形（不含被删除者）是否翻转或退化
+bool collapseFlips(const SimplifyContext& ctx, const std::vector<unsigned int>& idx,
+                   const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& adjacency,
+                   unsigned int u, unsigned int v) {
+    const glm::vec3 &pv = ctx.positions[v];
+    for (unsigned int a = offsets[u]; a < offsets[u + 1]; ++a) {
+        const unsigned int *tri = &idx[static_cast<size_t>(adjacency[a]) * 3];
+        if (tri[0] == v || tri[1] == v || tri[2] == v) continue;
+        glm::vec3 p[3], q[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = ctx.positions[tri[k]];
+            q[k] = tri[k] == u ? pv : p[k];
+        }
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        if (glm::dot(before, after) <= kFlipThreshold * glm::length(before) * glm::length(after)) return true;
+    }
+    return false;
+}
+
+// 逐轮并行无关的边折叠：每轮按代价排序，互不相邻的折叠一次完成，然后重建拓扑
+float simplifyLevel(const SimplifyContext& ctx, const std::vector<unsigned int>& indices, size_t targetIndexCount,
+                    std::vector<unsigned int>& out) {
+    const size_t vertexCount = ctx.positions.size();
+    std::vector<unsigned int> idx(indices);
+    std::vector<Quadric> quadrics(ctx.quadrics);
+    std::vector<unsigned int> offsets, adjacency, remap(vertexCount);
+    std::vector<unsigned char> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    double maxError = 0.0;
+    const size_t targetTris = targetIndexCount / 3;
+
+    while (idx.size() / 3 > targetTris) {
+        // 顶点 → 三角形 表
+        offsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < idx.size(); ++i) offsets[idx[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+        adjacency.resize(idx.size());
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < idx.size(); ++i) adjacency[fill[idx[i]]++] = static_cast<unsigned int>(i / 3);
+
+        // 候选边：流形内部边在两个三角形中方向相反，只取 a < b 的一次；
+        // 只以 a > b 出现的是边界边，两端均已锁定，无需考虑
+        collapses.clear();
+        for (size_t t = 0; t < idx.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int a = idx[t + k], b = idx[t + (k + 1) % 3];
+                if (a > b) continue;
+                // 取代价较小的可行方向
+                Collapse best;
+                best.cost = std::numeric_limits<float>::max();
+                for (int dir = 0; dir < 2; ++dir) {
+                    unsigned int u = dir ? b : a, v = dir ? a : b;
+                    if (ctx.locked[u]) continue;
+                    glm::vec3 dp = ctx.positions[u] - ctx.positions[v];
+                    glm::vec3 dn = ctx.normals[u] - ctx.normals[v];
+                    double pos = quadricError(quadrics[u], ctx.positions[v]);
+                    double cost = pos + kNormalWeight * glm::dot(dn, dn) * glm::dot(dp, dp);
+                    if (cost < best.cost) {
+                        best.u = u;
+                        best.v = v;
+                        best.cost = static_cast<float>(cost);
+                        best.positionError = static_cast<float>(pos);
+                    }
+                }
+                if (best.cost < std::numeric_limits<float>::max()) collapses.push_back(best);
+            }
+        }
+        if (collapses.empty()) break;
+
+        // 每次内部边折叠约删除 2 个三角形；只排序代价不超过目标位置 1.5 倍的候选
+        const size_t currentTris = idx.size() / 3;
+        const size_t goal = std::max<size_t>(1, (currentTris - targetTris) / 2);
+        if (goal < collapses.size()) {
+            std::nth_element(collapses.begin(), collapses.begin() + goal, collapses.end(), collapseLess);
+            const float errorGoal = collapses[goal].cost * kErrorGoalSlack;
+            size_t keep = 0;
+            for (size_t i = 0; i < collapses.size(); ++i) {
+                if (collapses[i].cost <= errorGoal) collapses[keep++] = collapses[i];
+            }
+            collapses.resize(keep);
+        }
+        std::sort(collapses.begin(), collapses.end(), collapseLess);
+
+        for (size_t v = 0; v < vertexCount; ++v) remap[v] = static_cast<unsigned int>(v);
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t removed = 0, performed = 0;
+        for (size_t i = 0; i < collapses.size(); ++i) {
+            const Collapse &c = collapses[i];
+            if (currentTris - removed <= targetTris) break;
+            if (touched[c.u] || touched[c.v]) continue;
+            if (collapseFlips(ctx, idx, offsets, adjacency, c.u, c.v)) continue;
+
+            remap[c.u] = c.v;
+            quadricAdd(quadrics[c.v], quadrics[c.u]);
+            touched[c.u] = touched[c.v] = 1;
+            for (unsigned int a = offsets[c.u]; a < offsets[c.u + 1]; ++a) {
+                const unsigned int *tri = &idx[static_cast<size_t>(adjacency[a]) * 3];
+                if (tri[0] == c.v || tri[1] == c.v || tri[2] == c.v) ++removed;
+            }
+            maxError = std::max(maxError, static_cast<double>(c.positionError));
+            ++performed;
+        }
+        if (performed == 0) break;
+
+        // 应用折叠并删除退化三角形
+        size_t write = 0;
+        for (size_t t = 0; t < idx.size(); t += 3) {
+            unsigned int a = remap[idx[t]], b = remap[idx[t + 1]], c = remap[idx[t + 2]];
+            if (a == b || b == c || a == c) continue;
+            idx[write++] = a;
+            idx[write++] = b;
+            idx[write++] = c;
+        }
+        idx.resize(write);
+    }
+
+    out.swap(idx);
+    return static_cast<float>(std::sqrt(maxError)) * ctx.scale;
+}
+
+} // namespace
+
+float simplifyMesh(const Mesh& mesh, const std::vector<unsigned int>& indices, size_t targetIndexCount,
+                   std::vector<unsigned int>& out) {
+    SimplifyContext ctx;
+    buildContext(mesh, indices, ctx);
+    return simplifyLevel(ctx, indices, targetIndexCount, out);
+}
+
+void buildLodChain(Mesh& mesh, const float* ratios, size_t ratioCount) {
+    const size_t baseCount = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+    const std::vector<unsigned int> base(mesh.indices.begin(), mesh.indices.begin() + baseCount);
+    mesh.indices.resize(baseCount);
+    mesh.lods.clear();
+    MeshLod lod0;
+    lod0.indexOffset = 0;
+    lod0.indexCount = static_cast<uint32_t>(baseCount);
+    lod0.error = 0.0f;
+    lod0.reserved = 0.0f;
+    mesh.lods.push_back(lod0);
+    if (baseCount == 0 || ratioCount == 0) return;
+
+    SimplifyContext ctx;
+    buildContext(mesh, base, ctx);
+
+    // 各级互相独立地从完整网格简化，级别之间并行
+    std::vector<std::vector<unsigned int> > levels(ratioCount);
+    std::vector<float> errors(ratioCount, 0.0f);
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    ThreadPool::shared().parallelFor(ratioCount, [&](size_t i) {
+        size_t target = static_cast<size_t>(baseCount / 3 * ratios[i]) * 3;
+        errors[i] = simplifyLevel(ctx, base, std::max<size_t>(target, 3), levels[i]);
+        optimizeVertexCache(levels[i], vertexCount);
+    });
+
+    size_t previous = baseCount;
+    float previousError = 0.0f;
+    for (size_t i = 0; i < ratioCount && mesh.lods.size() < kMaxLods; ++i) {
+        if (levels[i].empty() || levels[i].size() > previous * 9 / 10) continue;
+        MeshLod lod;
+        lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+        lod.indexCount = static_cast<uint32_t>(levels[i].size());
+        lod.error = std::max(errors[i], previousError); // 保证误差随级别单调，便于按屏幕误差选择
+        lod.reserved = 0.0f;
+        mesh.lods.push_back(lod);
+        mesh.indices.insert(mesh.indices.end(), levels[i].begin(), levels[i].end());
+        previous = levels[i].size();
+        previousError = lod.error;
+    }
+}
@@ -0,0 +1,105 @@
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace {
+
+// parallelFor 的共享状态：迟到的辅助任务可能在 parallelFor 返回后才运行，
+// 因此用 shared_ptr 保活
+struct ForState {
+    std::function<void(size_t)> fn;
+    size_t count;
+    std::atomic<size_t> next;
+    std::atomic<size_t> done;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    void run() {
+        for (;;) {
+            size_t i = next.fetch_add(1);
+            if (i >= count) return;
+            fn(i);
+            if (done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads) : stop_(false) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // 调用线程本身也算一个
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void ThreadPool::submit(const std::function<void()>& task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(task);
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned maxThreads) {
+    if (count == 0) return;
+    unsigned threads = size();
+    if (maxThreads && maxThreads < threads) threads = maxThreads;
+    if (threads <= 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::shared_ptr<ForState> state = std::make_shared<ForState>();
+    state->fn = fn;
+    state->count = count;
+    state->next = 0;
+    state->done = 0;
+
+    size_t helpers = std::min<size_t>(threads - 1, count - 1);
+    for (size_t h = 0; h < helpers; ++h) {
+        submit([state]() { state->run(); });
+    }
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
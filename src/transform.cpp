@@ -0,0 +1,17 @@
+#include "transform.h"
+
+glm::mat3 normalMatrix(const glm::mat4& model) {
+    glm::vec3 a(model[0]), b(model[1]), c(model[2]);
+    // inverse(M)^T 的三列为 (b×c, c×a, a×b) / det(M)
+    glm::mat3 cofactor(glm::cross(b, c), glm::cross(c, a), glm::cross(a, b));
+    float det = glm::dot(a, cofactor[0]);
+    return det != 0.0f ? cofactor * (1.0f / det) : cofactor;
+}
+
+void computeTransforms(const glm::mat4& viewProj, const glm::mat4* models, size_t count, ObjectTransform* out) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i].model = models[i];
+        out[i].mvp = viewProj * models[i];
+        out[i].normal = normalMatrix(models[i]);
+    }
+}
@@ -0,0 +1,51 @@
+#include "uniformblocks.h"
+
+#include <cstring>
+
+#include "glstate.h"
+#include "shader.h"
+
+void bindUniformBlocks(Shader& shader) {
+    shader.bindUniformBlock("FrameBlock", kFrameBlockBinding);
+    shader.bindUniformBlock("LightBlock", kLightBlockBinding);
+    shader.bindUniformBlock("MaterialBlock", kMaterialBlockBinding);
+    shader.bindUniformBlock("MaterialTable", kMaterialTableBinding);
+    shader.bindUniformBlock("CullBlock", kCullBlockBinding);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glState().deleteBuffer(buffer_);
+}
+
+void UniformBuffer::create(GLuint binding, size_t blockSize, unsigned count) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment <= 0) alignment = 256;
+    binding_ = binding;
+    blockSize_ = blockSize;
+    stride_ = (blockSize + alignment - 1) / alignment * alignment;
+    count_ = count;
+    shadow_.assign(blockSize * count, 0);
+    uploaded_.assign(count, false);
+
+    if (!buffer_) glGenBuffers(1, &buffer_);
+    glState().bindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(stride_ * count), NULL, GL_DYNAMIC_DRAW);
+}
+
+bool UniformBuffer::update(unsigned index, const void* block) {
+    if (index >= count_) return false;
+    unsigned char *shadow = &shadow_[index * blockSize_];
+    if (uploaded_[index] && memcmp(shadow, block, blockSize_) == 0) return false;
+    memcpy(shadow, block, blockSize_);
+    uploaded_[index] = true;
+    glState().bindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(index * stride_), static_cast<GLsizeiptr>(blockSize_),
+                    block);
+    return true;
+}
+
+void UniformBuffer::bind(unsigned index) const {
+    glState().bindBufferRange(GL_UNIFORM_BUFFER, binding_, buffer_, static_cast<GLintptr>(index * stride_),
+                              static_cast<GLsizeiptr>(blockSize_));
+}
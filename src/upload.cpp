@@ -0,0 +1,33 @@
+#include "upload.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "glstate.h"
+
+void UploadQueue::add(GLuint buffer, const void* data, size_t bytes) {
+    glState().bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(bytes), NULL, GL_STATIC_DRAW);
+    if (bytes == 0) return;
+    Pending p = {buffer, static_cast<const unsigned char*>(data), bytes, 0};
+    pending_.push_back(p);
+}
+
+size_t UploadQueue::step(double budgetMs) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t uploaded = 0;
+    while (!pending_.empty()) {
+        Pending &p = pending_.front();
+        glState().bindBuffer(GL_COPY_WRITE_BUFFER, p.buffer);
+        const size_t n = std::min(kChunkBytes, p.bytes - p.offset);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(p.offset), static_cast<GLsizeiptr>(n),
+                        p.data + p.offset);
+        p.offset += n;
+        uploaded += n;
+        if (p.offset == p.bytes) pending_.pop_front();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (ms >= budgetMs) break;
+    }
+    bytesUploaded_ += uploaded;
+    return uploaded;
+}
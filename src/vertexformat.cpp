@@ -0,0 +1,203 @@
+#include "vertexformat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "threadpool.h"
+
+namespace {
+
+const size_t kVertexBlock = 65536; // 每个并行任务处理的顶点数
+
+// 量化格式的顶点：pos 占 4 个 uint16（第 4 个为填充），法线 32 位
+struct QuantizedVertex {
+    uint16_t pos[4];
+    uint32_t normal;
+};
+static_assert(sizeof(QuantizedVertex) == 12, "QuantizedVertex must be 12 bytes");
+
+// 与 GL 归一化整数转换规则一致（GL 4.2+：c / (2^(b-1) - 1)，下限 -1）
+inline float unorm16ToFloat(uint16_t v) { return v / 65535.0f; }
+inline float snorm16ToFloat(int16_t v) { return std::max(v / 32767.0f, -1.0f); }
+inline float snorm10ToFloat(int v) { return std::max(v / 511.0f, -1.0f); }
+
+// 逐分量最小误差的八面体量化：在四个 floor / ceil 组合中取解码后夹角最小者
+uint32_t packOct16(const glm::vec3& n) {
+    glm::vec2 e = octEncode(n) * 32767.0f;
+    float bx[2] = {std::floor(e.x), std::ceil(e.x)};
+    float by[2] = {std::floor(e.y), std::ceil(e.y)};
+    int16_t best[2] = {0, 0};
+    float bestDot = -2.0f;
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            int16_t q[2] = {static_cast<int16_t>(glm::clamp(bx[i], -32767.0f, 32767.0f)),
+                            static_cast<int16_t>(glm::clamp(by[j], -32767.0f, 32767.0f))};
+            float d = glm::dot(octDecode(glm::vec2(snorm16ToFloat(q[0]), snorm16ToFloat(q[1]))), n);
+            if (d > bestDot) {
+                bestDot = d;
+                best[0] = q[0];
+                best[1] = q[1];
+            }
+        }
+    }
+    return static_cast<uint32_t>(static_cast<uint16_t>(best[0])) |
+           (static_cast<uint32_t>(static_cast<uint16_t>(best[1])) << 16);
+}
+
+glm::vec3 unpackOct16(uint32_t v) {
+    int16_t x = static_cast<int16_t>(v & 0xFFFF);
+    int16_t y = static_cast<int16_t>(v >> 16);
+    return octDecode(glm::vec2(snorm16ToFloat(x), snorm16ToFloat(y)));
+}
+
+// GL_INT_2_10_10_10_REV：x 位于低 10 位，w（2 位）恒为 0
+uint32_t pack1010102(const glm::vec3& n) {
+    uint32_t out = 0;
+    for (int i = 0; i < 3; ++i) {
+        int c = static_cast<int>(std::lround(glm::clamp(n[i], -1.0f, 1.0f) * 511.0f));
+        out |= (static_cast<uint32_t>(c) & 0x3FFu) << (10 * i);
+    }
+    return out;
+}
+
+glm::vec3 unpack1010102(uint32_t v) {
+    glm::vec3 n;
+    for (int i = 0; i < 3; ++i) {
+        int c = static_cast<int>((v >> (10 * i)) & 0x3FFu);
+        if (c & 0x200) c -= 0x400; // 符号扩展
+        n[i] = snorm10ToFloat(c);
+    }
+    return glm::normalize(n);
+}
+
+inline float angleDegrees(const glm::vec3& a, const glm::vec3& b) {
+    // atan2 形式在小角度下比 acos(dot) 精确
+    return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+}
+
+} // namespace
+
+bool parseVertexFormat(const std::string& name, VertexFormat& out) {
+    if (name == "float") out = VERTEX_FLOAT32;
+    else if (name == "q16-oct16") out = VERTEX_Q16_OCT16;
+    else if (name == "q16-packed") out = VERTEX_Q16_PACKED;
+    else return false;
+    return true;
+}
+
+const char* vertexFormatName(VertexFormat format) {
+    switch (format) {
+    case VERTEX_Q16_OCT16: return "q16-oct16";
+    case VERTEX_Q16_PACKED: return "q16-packed";
+    default: return "float";
+    }
+}
+
+VertexLayout vertexLayout(VertexFormat format) {
+    if (format == VERTEX_FLOAT32) return VertexLayout::positionNormal();
+    VertexLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.stride = sizeof(QuantizedVertex);
+    layout.attribCount = 2;
+    layout.attribs[0].location = 0;
+    layout.attribs[0].components = 3;
+    layout.attribs[0].type = ATTRIB_UNORM16;
+    layout.attribs[0].offset = 0;
+    layout.attribs[1].location = 1;
+    layout.attribs[1].offset = offsetof(QuantizedVertex, normal);
+    if (format == VERTEX_Q16_OCT16) {
+        layout.attribs[1].components = 2;
+        layout.attribs[1].type = ATTRIB_SNORM16;
+    } else {
+        layout.attribs[1].components = 4;
+        layout.attribs[1].type = ATTRIB_SNORM_2_10_10_10;
+    }
+    return layout;
+}
+
+int normalEncoding(const VertexLayout& layout) {
+    return (layout.attribCount > 1 && layout.attribs[1].components == 2) ? 1 : 0;
+}
+
+glm::vec2 octEncode(const glm::vec3& n) {
+    float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (sum <= 0.0f) return glm::vec2(0.0f);
+    glm::vec2 e(n.x / sum, n.y / sum);
+    if (n.z < 0.0f) {
+        // 下半球沿对角线折叠
+        glm::vec2 folded((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+        e = folded;
+    }
+    return e;
+}
+
+glm::vec3 octDecode(const glm::vec2& e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+MeshBuffers packMesh(const Mesh& mesh, VertexFormat format, PackedMesh& packed, QuantizationError* error) {
+    packed.indices = mesh.packedIndices();
+    MeshBuffers b = makeMeshBuffers(mesh, packed.indices);
+    if (error) error->position = error->positionRel = error->normalDegrees = 0.0f;
+    if (format == VERTEX_FLOAT32) {
+        packed.vertices.clear();
+        return b;
+    }
+
+    // 位置相对包围盒量化到 [0, 65535]
+    const glm::vec3 extent = b.boundsMax - b.boundsMin;
+    const glm::vec3 offset = b.boundsMin;
+    glm::vec3 inv;
+    for (int i = 0; i < 3; ++i) inv[i] = extent[i] > 0.0f ? 1.0f / extent[i] : 0.0f;
+
+    const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+    packed.vertices.resize(vertexCount * sizeof(QuantizedVertex));
+    QuantizedVertex *out = reinterpret_cast<QuantizedVertex *>(packed.vertices.data());
+    const size_t blocks = (vertexCount + kVertexBlock - 1) / kVertexBlock;
+    std::vector<float> posError(blocks, 0.0f), nrmError(blocks, 0.0f);
+    ThreadPool::shared().parallelFor(blocks, [&](size_t block) {
+        const size_t end = std::min(vertexCount, (block + 1) * kVertexBlock);
+        for (size_t v = block * kVertexBlock; v < end; ++v) {
+            const float *src = &mesh.vertices[v * 6];
+            QuantizedVertex &q = out[v];
+            glm::vec3 p(src[0], src[1], src[2]);
+            for (int i = 0; i < 3; ++i) {
+                float u = glm::clamp((p[i] - offset[i]) * inv[i], 0.0f, 1.0f);
+                q.pos[i] = static_cast<uint16_t>(std::lround(u * 65535.0f));
+                float decoded = offset[i] + extent[i] * unorm16ToFloat(q.pos[i]);
+                posError[block] = std::max(posError[block], std::fabs(decoded - p[i]));
+            }
+            q.pos[3] = 0;
+
+            glm::vec3 n(src[3], src[4], src[5]);
+            float len = glm::length(n);
+            n = len > 0.0f ? n / len : glm::vec3(0.0f, 0.0f, 1.0f);
+            q.normal = (format == VERTEX_Q16_OCT16) ? packOct16(n) : pack1010102(n);
+            glm::vec3 decoded = (format == VERTEX_Q16_OCT16) ? unpackOct16(q.normal) : unpack1010102(q.normal);
+            nrmError[block] = std::max(nrmError[block], angleDegrees(decoded, n));
+        }
+    });
+
+    b.layout = vertexLayout(format);
+    b.vertexData = packed.vertices.data();
+    b.vertexBytes = packed.vertices.size();
+    b.positionScale = extent;
+    b.positionOffset = offset;
+    if (error) {
+        for (size_t i = 0; i < blocks; ++i) {
+            error->position = std::max(error->position, posError[i]);
+            error->normalDegrees = std::max(error->normalDegrees, nrmError[i]);
+        }
+        float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+        error->positionRel = maxExtent > 0.0f ? error->position / maxExtent : 0.0f;
+    }
+    return b;
+}
@@ -0,0 +1,329 @@
+// CPU 侧回归测试（不需要 GL 上下文，由 ctest 运行）：以 testcase/*.obj 检查
+// 分块并行解析、顶点去重、XXH64、顶点缓存优化、LOD 链与视锥剔除
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "frustum.h"
+#include "hash.h"
+#include "loadobj.h"
+#include "mesh.h"
+#include "meshopt.h"
+#include "objparser.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (ok) return;
+    std::cout << "FAILED: " << what << std::endl;
+    ++failures;
+}
+
+const char* const kModels[] = {"cube", "pyramid", "square", "sphere", "dinosaur"};
+
+std::string modelPath(const char* name) {
+    return std::string(TEST_DIR) + "/" + name + ".obj";
+}
+
+bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+ObjLoadOptions plainOptions() {
+    ObjLoadOptions options;
+    options.threads = 1;
+    options.optimize = false;
+    options.lods = false;
+    return options;
+}
+
+// 三角形按顶点轮转到最小下标在前（保持绕序），便于比较三角形多重集
+std::vector<uint64_t> canonicalTriangles(const std::vector<unsigned int>& indices, size_t first, size_t count) {
+    std::vector<uint64_t> out;
+    for (size_t t = first; t + 3 <= first + count; t += 3) {
+        unsigned int a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        while (a > b || a > c) {
+            unsigned int x = a;
+            a = b;
+            b = c;
+            c = x;
+        }
+        out.push_back((static_cast<uint64_t>(a) << 42) | (static_cast<uint64_t>(b) << 21) | c);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+bool sameObjData(const ObjData& a, const ObjData& b) {
+    if (a.positions != b.positions || a.normals != b.normals || a.corners.size() != b.corners.size()) return false;
+    for (size_t i = 0; i < a.corners.size(); ++i) {
+        if (a.corners[i].v != b.corners[i].v || a.corners[i].n != b.corners[i].n) return false;
+    }
+    return true;
+}
+
+void testHash() {
+    struct Vector { const char* text; size_t size; uint64_t seed; uint64_t expected; };
+    const char spam[] = "Nobody inspects the spammish repetition";
+    const Vector vectors[] = {
+        {"", 0, 0, 0xEF46DB3751D8E999ull},
+        {"a", 1, 0, 0xD24EC4F1A98C6E5Bull},
+        {"abc", 3, 0, 0x44BC2CF5AD770999ull},
+        {spam, sizeof(spam) - 1, 0, 0xFBCEA83C8A378BF1ull},
+        {"", 0, 1, 0xD5AFBA1336A3BE4Bull},
+        {"abc", 3, 0x9E3779B97F4A7C15ull, 0x2ED0F59D6B43AC8Bull},
+    };
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i) {
+        const Vector &v = vectors[i];
+        check(hash64(v.text, v.size, v.seed) == v.expected, std::string("XXH64 of \"") + v.text + "\"");
+    }
+    // 覆盖 32 字节条带、8 / 4 / 1 字节尾部的全部路径
+    std::vector<unsigned char> bytes;
+    for (int r = 0; r < 4; ++r) {
+        for (int i = 0; i < 256; ++i) bytes.push_back(static_cast<unsigned char>(i));
+    }
+    bytes.push_back('x');
+    bytes.push_back('y');
+    bytes.push_back('z');
+    check(hash64(bytes.data(), bytes.size(), 12345) == 0xE323A559C0F2EE86ull, "XXH64 of 1027 bytes");
+}
+
+void testParallelParse() {
+    // 测试模型不足以切块（每块至少 1 MB）：把全部模型重复拼接，并追加带法线与负数索引的记录
+    std::string text;
+    for (int r = 0; r < 3; ++r) {
+        for (size_t m = 0; m < sizeof(kModels) / sizeof(kModels[0]); ++m) {
+            std::string model;
+            check(readText(modelPath(kModels[m]), model), std::string("read ") + kModels[m]);
+            text += model + "\n";
+        }
+    }
+    for (int i = 0; i < 40000; ++i) {
+        char line[160];
+        snprintf(line, sizeof(line), "v %d 0.5 %d\nv %d 1.5 %d\nv %d 2.5 %d\nvn 0 %d 1\nf -3//-1 -2//-1 -1//-1\n",
+                 i, -i, i + 1, -i, i, 1 - i, i % 7);
+        text += line;
+    }
+    for (int r = 0; r < 2; ++r) {
+        std::string model;
+        readText(modelPath("sphere"), model);
+        text += model + "\n";
+    }
+    const char *begin = text.data(), *end = text.data() + text.size();
+    check(text.size() > (4u << 20), "parse input spans several chunks");
+
+    ObjData serial;
+    parseOBJRange(begin, end, serial);
+    const unsigned threadCounts[] = {2, 3, 4, 8};
+    for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t) {
+        ObjData chunked;
+        parseOBJParallel(begin, end, chunked, threadCounts[t]);
+        std::ostringstream what;
+        what << "chunked parse with " << threadCounts[t] << " threads equals serial parse";
+        check(sameObjData(serial, chunked), what.str());
+    }
+    check(!serial.normals.empty() && serial.corners.size() % 3 == 0, "parse produced normals and triangles");
+}
+
+void testDeduplication() {
+    for (size_t m = 0; m < sizeof(kModels) / sizeof(kModels[0]); ++m) {
+        const std::string path = modelPath(kModels[m]);
+        int flatCount = 0;
+        std::vector<float> flat = loadOBJ(path, flatCount, plainOptions());
+        Mesh mesh;
+        check(loadOBJMesh(path, mesh, plainOptions()), std::string("load ") + kModels[m]);
+
+        // 未优化时索引按角点顺序，逐角点展开后与 loadOBJ 完全一致
+        bool same = mesh.indexCount() == flatCount;
+        bool inRange = true;
+        for (size_t c = 0; same && c < mesh.indices.size(); ++c) {
+            unsigned int vi = mesh.indices[c];
+            inRange = inRange && vi < static_cast<unsigned int>(mesh.vertexCount());
+            if (!inRange) break;
+            same = std::memcmp(&mesh.vertices[vi * 6], &flat[c * 6], 6 * sizeof(float)) == 0;
+        }
+        check(inRange, std::string(kModels[m]) + ": indices within the vertex buffer");
+        check(same, std::string(kModels[m]) + ": indexed mesh expands to the flat vertices");
+
+        // 没有 vn 时每个被引用的位置恰好一个顶点
+        ObjData obj;
+        size_t bytes = 0;
+        parseOBJFile(path, obj, bytes, 1);
+        std::set<int> referenced;
+        for (size_t c = 0; c + 2 < obj.corners.size(); c += 3) {
+            bool valid = true;
+            for (int i = 0; i < 3; ++i) {
+                valid = valid && obj.corners[c + i].v >= 0 && obj.corners[c + i].v < static_cast<int>(obj.positions.size());
+            }
+            for (int i = 0; valid && i < 3; ++i) referenced.insert(obj.corners[c + i].v);
+        }
+        if (obj.normals.empty()) {
+            check(referenced.size() == static_cast<size_t>(mesh.vertexCount()),
+                  std::string(kModels[m]) + ": one vertex per referenced position");
+        }
+    }
+}
+
+void testCacheOptimizer() {
+    const char* const models[] = {"sphere", "dinosaur"};
+    for (size_t m = 0; m < 2; ++m) {
+        Mesh mesh;
+        loadOBJMesh(modelPath(models[m]), mesh, plainOptions());
+        const size_t vertexCount = static_cast<size_t>(mesh.vertexCount());
+        const std::vector<uint64_t> original = canonicalTriangles(mesh.indices, 0, mesh.indices.size());
+        const float acmrBefore = analyzeVertexCache(mesh.indices, vertexCount).acmr;
+
+        std::vector<unsigned int> indices = mesh.indices;
+        std::vector<unsigned int> clusters;
+        optimizeVertexCache(indices, vertexCount, kVertexCacheSize, &clusters);
+        const std::string name = models[m];
+        check(canonicalTriangles(indices, 0, indices.size()) == original, name + ": Tipsify keeps every triangle");
+        const float acmrTipsify = analyzeVertexCache(indices, vertexCount).acmr;
+        check(acmrTipsify <= acmrBefore, name + ": Tipsify does not raise ACMR");
+        bool clustersValid = !clusters.empty() && clusters[0] == 0;
+        for (size_t i = 1; i < clusters.size(); ++i) {
+            clustersValid = clustersValid && clusters[i] > clusters[i - 1] && clusters[i] < indices.size() / 3;
+        }
+        check(clustersValid, name + ": cluster starts ascend from 0");
+
+        optimizeOverdraw(indices, clusters, mesh.vertices.data(), 6, vertexCount);
+        check(canonicalTriangles(indices, 0, indices.size()) == original, name + ": overdraw pass keeps every triangle");
+        // ACMR 阈值按簇（缓存清空后）计算，整体只保证仍优于原始顺序
+        check(analyzeVertexCache(indices, vertexCount).acmr < acmrBefore, name + ": overdraw pass keeps ACMR gain");
+
+        // 顶点拉取优化：顶点按首次引用顺序编号，三角形引用的顶点数据不变
+        Mesh fetched = mesh;
+        fetched.indices = indices;
+        optimizeVertexFetch(fetched);
+        bool sameData = fetched.indices.size() == indices.size();
+        unsigned int next = 0;
+        bool firstUse = true;
+        for (size_t c = 0; sameData && c < indices.size(); ++c) {
+            unsigned int vi = fetched.indices[c];
+            if (vi == next) ++next;
+            else if (vi > next) firstUse = false;
+            sameData = std::memcmp(&fetched.vertices[vi * 6], &mesh.vertices[indices[c] * 6], 6 * sizeof(float)) == 0;
+        }
+        check(sameData, name + ": vertex fetch reorder keeps vertex data");
+        check(firstUse && next == static_cast<unsigned int>(fetched.vertexCount()),
+              name + ": vertices are numbered in first-use order");
+    }
+}
+
+void testLodChain() {
+    const char* const models[] = {"sphere", "dinosaur"};
+    for (size_t m = 0; m < 2; ++m) {
+        ObjLoadOptions options = plainOptions();
+        options.lods = true;
+        Mesh mesh;
+        loadOBJMesh(modelPath(models[m]), mesh, options);
+        const std::string name = models[m];
+        check(mesh.lods.size() > 1 && mesh.lods.size() <= kMaxLods, name + ": LOD chain has several levels");
+        if (mesh.lods.empty()) continue;
+        check(mesh.lods[0].indexOffset == 0 && mesh.lods[0].indexCount > 0 && mesh.lods[0].error == 0.0f,
+              name + ": LOD 0 is the full mesh");
+        for (size_t i = 1; i < mesh.lods.size(); ++i) {
+            const MeshLod &lod = mesh.lods[i], &prev = mesh.lods[i - 1];
+            std::ostringstream level;
+            level << name << " LOD " << i;
+            check(lod.error >= prev.error, level.str() + ": error does not decrease");
+            check(lod.indexCount % 3 == 0 && lod.indexCount * 10 <= prev.indexCount * 9,
+                  level.str() + ": at least 10% fewer triangles");
+            bool inRange = lod.indexOffset + lod.indexCount <= mesh.indices.size();
+            for (size_t k = lod.indexOffset; inRange && k < lod.indexOffset + lod.indexCount; ++k) {
+                inRange = mesh.indices[k] < static_cast<unsigned int>(mesh.vertexCount());
+            }
+            check(inRange, level.str() + ": indices within the shared vertex buffer");
+            // 只折叠到已有顶点：简化后不出现退化三角形
+            bool degenerate = false;
+            for (size_t k = lod.indexOffset; inRange && k + 3 <= lod.indexOffset + lod.indexCount; k += 3) {
+                unsigned int a = mesh.indices[k], b = mesh.indices[k + 1], c = mesh.indices[k + 2];
+                degenerate = degenerate || a == b || b == c || a == c;
+            }
+            check(!degenerate, level.str() + ": no degenerate triangles");
+        }
+    }
+}
+
+void testFrustum() {
+    // 相机在原点看向 -Z，竖直视角 90°，宽高比 1：深度 d 处视锥半宽为 d（盒子近侧 z = -9、远侧 z = -11）
+    const glm::mat4 viewProj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    const Frustum frustum = Frustum::fromMatrix(viewProj);
+    struct Case { glm::vec3 center; float extent; bool visible; const char* what; };
+    const Case cases[] = {
+        {glm::vec3(0.0f, 0.0f, -10.0f), 1.0f, true, "inside"},
+        {glm::vec3(0.0f, 0.0f, 10.0f), 1.0f, false, "behind the camera"},
+        {glm::vec3(0.0f, 0.0f, -0.05f), 0.5f, true, "straddling the near plane"},
+        {glm::vec3(0.0f, 0.0f, -102.0f), 1.0f, false, "beyond the far plane"},
+        {glm::vec3(0.0f, 0.0f, -99.5f), 1.0f, true, "straddling the far plane"},
+        {glm::vec3(-10.5f, 0.0f, -10.0f), 1.0f, true, "straddling the left plane"},
+        {glm::vec3(-13.0f, 0.0f, -10.0f), 1.0f, false, "left of the frustum"},
+        {glm::vec3(0.0f, 13.0f, -10.0f), 1.0f, false, "above the frustum"},
+        {glm::vec3(0.0f, -10.5f, -10.0f), 1.0f, true, "straddling the bottom plane"},
+    };
+    const size_t count = sizeof(cases) / sizeof(cases[0]);
+    // 单位包围盒按各物体的平移与缩放变换到世界空间，再批量测试（SIMD 4 个一组，余下逐个）
+    std::vector<glm::mat4> models(count);
+    for (size_t i = 0; i < count; ++i) {
+        models[i] = glm::scale(glm::translate(glm::mat4(1.0f), cases[i].center), glm::vec3(cases[i].extent));
+    }
+    BoxArrays boxes;
+    transformBox(glm::vec3(0.0f), glm::vec3(1.0f), models.data(), count, boxes);
+    std::vector<uint8_t> visible(count);
+    unsigned expected = 0;
+    for (size_t i = 0; i < count; ++i) expected += cases[i].visible ? 1 : 0;
+    check(frustum.cullBoxes(boxes, visible.data()) == expected, "box culling visible count");
+    for (size_t i = 0; i < count; ++i) {
+        check((visible[i] != 0) == cases[i].visible, std::string("box ") + cases[i].what);
+    }
+
+    // 批量球测试与逐个测试一致
+    SphereArrays spheres;
+    spheres.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        spheres.x[i] = cases[i].center.x;
+        spheres.y[i] = cases[i].center.y;
+        spheres.z[i] = cases[i].center.z;
+        spheres.radius[i] = cases[i].extent;
+    }
+    frustum.cullSpheres(spheres, visible.data());
+    for (size_t i = 0; i < count; ++i) {
+        check((visible[i] != 0) == frustum.intersectsSphere(cases[i].center, cases[i].extent),
+              std::string("sphere batch matches single test: ") + cases[i].what);
+    }
+}
+
+}
+
+int main() {
+    testHash();
+    testParallelParse();
+    testDeduplication();
+    testCacheOptimizer();
+    testLodChain();
+    testFrustum();
+    if (failures) {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}